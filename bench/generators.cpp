@@ -0,0 +1,139 @@
+#include "generators.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "raster.hpp"
+
+namespace PTIT {
+
+Drawing LineSoup(int size, uint32_t seed) {
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<int> coord(0, size - 1);
+
+  Drawing drawing;
+  int count = std::max(size / 4, 1);
+  for (int index = 0; index < count; ++index) {
+    drawing.segments.emplace_back(Coord{coord(random), coord(random)},
+                                  Coord{coord(random), coord(random)});
+  }
+  return drawing;
+}
+
+Drawing Hatching(int size, uint32_t seed) {
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<double> angle(0, M_PI);
+
+  Drawing drawing;
+  int spacing = std::max(size / 64, 4);
+  for (int family = 0; family < 3; ++family) {
+    double direction = angle(random);
+    double dir_x = std::cos(direction);
+    double dir_y = std::sin(direction);
+
+    // lines through points spread along the normal, cut by the square
+    double center = size / 2.0;
+    for (double offset = -size; offset <= size; offset += spacing) {
+      double base_x = center - dir_y * offset;
+      double base_y = center + dir_x * offset;
+      Coord ends[2];
+      for (int end = 0; end < 2; ++end) {
+        double sign = end == 0 ? -1 : 1;
+        double x = std::clamp(base_x + sign * dir_x * size, 0.0, size - 1.0);
+        double y = std::clamp(base_y + sign * dir_y * size, 0.0, size - 1.0);
+        ends[end] = {static_cast<int>(x), static_cast<int>(y)};
+      }
+      if (!(ends[0] == ends[1])) {
+        drawing.segments.emplace_back(ends[0], ends[1]);
+      }
+    }
+  }
+  return drawing;
+}
+
+Drawing CircleField(int size, uint32_t seed) {
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<int> coord(0, size - 1);
+  std::uniform_int_distribution<int> radius(2, std::max(size / 32, 3));
+
+  Drawing drawing;
+  int count = std::max(size / 4, 1);
+  for (int index = 0; index < count; ++index) {
+    drawing.circles.emplace_back(Coord{coord(random), coord(random)},
+                                 radius(random));
+  }
+  return drawing;
+}
+
+Drawing CadDrawing(int size, uint32_t seed) {
+  std::mt19937 random(seed);
+  Drawing drawing;
+  auto add_rect = [&drawing](int x_begin, int y_begin, int x_end, int y_end) {
+    drawing.segments.emplace_back(Coord{x_begin, y_begin},
+                                  Coord{x_end, y_begin});
+    drawing.segments.emplace_back(Coord{x_end, y_begin}, Coord{x_end, y_end});
+    drawing.segments.emplace_back(Coord{x_end, y_end}, Coord{x_begin, y_end});
+    drawing.segments.emplace_back(Coord{x_begin, y_end},
+                                  Coord{x_begin, y_begin});
+  };
+
+  int margin = std::max(size / 64, 2);
+  add_rect(margin, margin, size - 1 - margin, size - 1 - margin);
+
+  int cells = std::max(size / 128, 1);
+  int cell = (size - 2 * margin) / cells;
+  std::uniform_int_distribution<int> inset(cell / 8, cell / 4);
+  std::uniform_int_distribution<int> holes(0, 3);
+  for (int row = 0; row < cells; ++row) {
+    for (int col = 0; col < cells; ++col) {
+      int x_begin = margin + col * cell + inset(random);
+      int y_begin = margin + row * cell + inset(random);
+      int x_end = margin + (col + 1) * cell - inset(random);
+      int y_end = margin + (row + 1) * cell - inset(random);
+      if (x_end - x_begin < 8 || y_end - y_begin < 8) {
+        continue;
+      }
+      add_rect(x_begin, y_begin, x_end, y_end);
+
+      Coord center = {(x_begin + x_end) / 2, (y_begin + y_end) / 2};
+      int radius = std::min(x_end - x_begin, y_end - y_begin) / 6;
+      int holes_num = holes(random);
+      for (int hole = 0; hole < holes_num; ++hole) {
+        drawing.circles.emplace_back(
+            Coord{center.x + (hole - holes_num / 2) * 2 * radius, center.y},
+            std::max(radius / 2, 1));
+      }
+      // center lines and a dimension line under the part
+      drawing.segments.emplace_back(Coord{x_begin - 2, center.y},
+                                    Coord{x_end + 2, center.y});
+      drawing.segments.emplace_back(Coord{center.x, y_begin - 2},
+                                    Coord{center.x, y_end + 2});
+      drawing.segments.emplace_back(Coord{x_begin, y_begin - 4},
+                                    Coord{x_end, y_begin - 4});
+      drawing.segments.emplace_back(Coord{x_begin, y_begin - 4},
+                                    Coord{x_begin + 3, y_begin - 2});
+      drawing.segments.emplace_back(Coord{x_end, y_begin - 4},
+                                    Coord{x_end - 3, y_begin - 2});
+    }
+  }
+  return drawing;
+}
+
+Bitmap Render(const Drawing& drawing, int size) {
+  Bitmap bitmap(size, size);
+  auto plot = [&bitmap, size](const Coord& point) {
+    if (point.x >= 0 && point.y >= 0 && point.x < size && point.y < size) {
+      bitmap.Set(point.x, point.y);
+    }
+  };
+  for (const auto& segment : drawing.segments) {
+    ForEachPixel(segment, plot);
+  }
+  for (const auto& circle : drawing.circles) {
+    ForEachPixel(circle, plot);
+  }
+  return bitmap;
+}
+
+}  // namespace PTIT
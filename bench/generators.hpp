@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "bitmap.hpp"
+#include "primitives.hpp"
+
+namespace PTIT {
+
+// Synthetic drawings on a size x size square, the same seed always gives the
+// same drawing.
+struct Drawing {
+  std::vector<Segment> segments;
+  std::vector<Circe> circles;
+
+  size_t PrimitivesNum() const { return segments.size() + circles.size(); }
+};
+
+// segments with random ends
+Drawing LineSoup(int size, uint32_t seed);
+// families of parallel lines at a few random angles
+Drawing Hatching(int size, uint32_t seed);
+// circles of random centers and radii
+Drawing CircleField(int size, uint32_t seed);
+// sheet frame, a grid of parts with outlines, holes and center lines, and
+// dimension lines between them
+Drawing CadDrawing(int size, uint32_t seed);
+
+// outlines of the drawing, clipped to the square
+Bitmap Render(const Drawing& drawing, int size);
+
+}  // namespace PTIT
@@ -0,0 +1,75 @@
+#include "harness.hpp"
+
+#include <sys/resource.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace PTIT {
+
+long PeakRssKb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    // "VmHWM:     1234 kB"
+    if (line.rfind("VmHWM:", 0) == 0) {
+      return std::stol(line.substr(6));
+    }
+  }
+  rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+  // kilobytes on Linux
+  return usage.ru_maxrss;
+}
+
+void ResetPeakRss() {
+  // the heap left by the last benchmark goes back to the system first, the
+  // peak drops to the resident set of the moment
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+}
+
+// a rate of zero for a run too short for the clock, JSON has no infinity
+double PerSecond(size_t count, double seconds) {
+  return seconds > 0 ? count / seconds : 0;
+}
+
+void Harness::Report(const BenchResult& result) {
+  results_.push_back(result);
+  std::fprintf(stderr, "%-36s %6d %8zu it %12.3f ms %10.3g px/s\n",
+               result.name.c_str(), result.size, result.iterations,
+               result.seconds * 1e3,
+               PerSecond(result.work.pixels, result.seconds));
+}
+
+void Harness::WriteJson(std::ostream& out) const {
+  long peak_rss_kb = PeakRssKb();
+  out << "{\n  \"benchmarks\": [";
+  for (size_t index = 0; index < results_.size(); ++index) {
+    const auto& result = results_[index];
+    out << (index == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name
+        << "\", \"size\": " << result.size
+        << ", \"iterations\": " << result.iterations
+        << ", \"seconds_per_iteration\": " << result.seconds
+        << ", \"pixels\": " << result.work.pixels
+        << ", \"primitives\": " << result.work.primitives
+        << ", \"pixels_per_second\": "
+        << PerSecond(result.work.pixels, result.seconds)
+        << ", \"primitives_per_second\": "
+        << PerSecond(result.work.primitives, result.seconds)
+        << ", \"peak_rss_kb\": " << result.peak_rss_kb << "}";
+    peak_rss_kb = std::max(peak_rss_kb, result.peak_rss_kb);
+  }
+  out << "\n  ],\n  \"peak_rss_kb\": " << peak_rss_kb << "\n}\n";
+}
+
+}  // namespace PTIT
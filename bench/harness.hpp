@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace PTIT {
+
+// what a single run of a benchmark went through
+struct Work {
+  size_t pixels = 0;
+  size_t primitives = 0;
+};
+
+struct BenchResult {
+  std::string name;
+  int size;
+  size_t iterations;
+  double seconds;
+  Work work;
+  // peak resident set of the process while the benchmark ran
+  long peak_rss_kb;
+};
+
+// time of a benchmark, setup done inside a run may be left out of it by
+// pausing the timer, it has to be resumed before the run returns
+class Timer {
+ public:
+  void Pause() {
+    elapsed_ += Clock::now() - start_;
+    running_ = false;
+  }
+  void Resume() {
+    start_ = Clock::now();
+    running_ = true;
+  }
+  double Seconds() const {
+    auto elapsed = elapsed_;
+    if (running_) {
+      elapsed += Clock::now() - start_;
+    }
+    return std::chrono::duration<double>(elapsed).count();
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point start_ = Clock::now();
+  Clock::duration elapsed_ = Clock::duration::zero();
+  bool running_ = true;
+};
+
+// The peak resident set of the process since the last ResetPeakRss, from
+// VmHWM of /proc/self/status; ru_maxrss, the peak over the whole life of the
+// process, where it cannot be read.
+long PeakRssKb();
+void ResetPeakRss();
+
+// Runs every benchmark whose name contains the filter until min_time seconds
+// of it are timed, at least once.
+class Harness {
+ public:
+  Harness(std::string filter, double min_time)
+      : filter_(std::move(filter)), min_time_(min_time) {}
+
+  bool Selected(const std::string& name) const {
+    return name.find(filter_) != std::string::npos;
+  }
+
+  // body(timer) makes a run and returns its work
+  template <typename Body>
+  void Run(const std::string& name, int size, Body&& body) {
+    if (!Selected(name)) {
+      return;
+    }
+    ResetPeakRss();
+    Timer timer;
+    Work work;
+    size_t iterations = 0;
+    do {
+      work = body(timer);
+      ++iterations;
+    } while (timer.Seconds() < min_time_);
+    Report({name, size, iterations, timer.Seconds() / iterations, work,
+            PeakRssKb()});
+  }
+
+  const std::vector<BenchResult>& GetResults() const { return results_; }
+  void WriteJson(std::ostream& out) const;
+
+ private:
+  std::string filter_;
+  double min_time_;
+  std::vector<BenchResult> results_;
+
+  void Report(const BenchResult& result);
+};
+
+}  // namespace PTIT
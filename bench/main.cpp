@@ -0,0 +1,211 @@
+#include <stdint.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binarize.hpp"
+#include "canvas.hpp"
+#include "generators.hpp"
+#include "harness.hpp"
+#include "primitive-batch.hpp"
+#include "primitives.hpp"
+
+using namespace PTIT;
+
+struct Options {
+  std::string filter;
+  double min_time = 0.5;
+  int max_size = 4096;
+  uint32_t seed = 1;
+  int threads = 1;
+  std::string out;
+};
+
+bool ParseOption(const std::string& arg, const std::string& name,
+                 std::string& value) {
+  if (arg.rfind(name + "=", 0) != 0) {
+    return false;
+  }
+  value = arg.substr(name.size() + 1);
+  return true;
+}
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  for (int index = 1; index < argc; ++index) {
+    std::string arg = argv[index];
+    std::string value;
+    if (ParseOption(arg, "--filter", value)) {
+      options.filter = value;
+    } else if (ParseOption(arg, "--min-time", value)) {
+      options.min_time = std::stod(value);
+    } else if (ParseOption(arg, "--max-size", value)) {
+      options.max_size = std::stoi(value);
+    } else if (ParseOption(arg, "--seed", value)) {
+      options.seed = static_cast<uint32_t>(std::stoul(value));
+    } else if (ParseOption(arg, "--threads", value)) {
+      options.threads = std::stoi(value);
+    } else if (ParseOption(arg, "--out", value)) {
+      options.out = value;
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--filter=SUBSTR] [--min-time=SECONDS] "
+                   "[--max-size=PIXELS] [--seed=N] [--threads=N] "
+                   "[--out=FILE]\n",
+                   argv[0]);
+      std::exit(2);
+    }
+  }
+  return options;
+}
+
+struct Generator {
+  const char* name;
+  Drawing (*generate)(int size, uint32_t seed);
+};
+
+const Generator kGenerators[] = {{"line_soup", LineSoup},
+                                 {"hatching", Hatching},
+                                 {"circle_field", CircleField},
+                                 {"cad", CadDrawing}};
+
+void RunSize(Harness& harness, const Options& options, int size) {
+  for (const auto& generator : kGenerators) {
+    std::string suffix = std::string("/") + generator.name;
+    auto drawing = generator.generate(size, options.seed);
+
+    if (!drawing.segments.empty()) {
+      harness.Run("segment_graphic" + suffix, size, [&](Timer&) {
+        Work work = {0, drawing.segments.size()};
+        for (const auto& segment : drawing.segments) {
+          work.pixels += segment.GetGraphic().size();
+        }
+        return work;
+      });
+      harness.Run("segment_area" + suffix, size, [&](Timer&) {
+        Work work = {0, drawing.segments.size()};
+        for (const auto& segment : drawing.segments) {
+          work.pixels += segment.GetArea(2).Size();
+        }
+        return work;
+      });
+
+      SegmentBatch batch(drawing.segments);
+      harness.Run("segment_batch_rotate" + suffix, size, [&](Timer&) {
+        Rotate(batch, {size / 2, size / 2}, 30);
+        return Work{0, batch.Size()};
+      });
+      harness.Run("segment_batch_lengths" + suffix, size, [&](Timer&) {
+        std::vector<double> lengths;
+        GetLengths(batch, lengths);
+        return Work{0, batch.Size()};
+      });
+    }
+
+    if (!drawing.circles.empty()) {
+      harness.Run("circle_graphic" + suffix, size, [&](Timer&) {
+        Work work = {0, drawing.circles.size()};
+        for (const auto& circle : drawing.circles) {
+          work.pixels += circle.GetGraphic().size();
+        }
+        return work;
+      });
+      harness.Run("circle_area" + suffix, size, [&](Timer&) {
+        Work work = {0, drawing.circles.size()};
+        for (const auto& circle : drawing.circles) {
+          work.pixels += circle.GetArea().Size();
+        }
+        return work;
+      });
+
+      if (harness.Selected("fulfill_area" + suffix)) {
+        std::vector<std::list<Coord>> borders;
+        for (const auto& circle : drawing.circles) {
+          borders.push_back(circle.GetGraphic());
+        }
+        harness.Run("fulfill_area" + suffix, size, [&](Timer&) {
+          Work work = {0, borders.size()};
+          for (const auto& border : borders) {
+            work.pixels += FulfillArea(border).Size();
+          }
+          return work;
+        });
+      }
+    }
+
+    if (harness.Selected("create_image" + suffix)) {
+      Canvas canvas(size, size, false, {255, 255, 255});
+      canvas.Draw(drawing.segments, {0, 0, 0});
+      canvas.Draw(drawing.circles, {0, 0, 0});
+      auto path = std::filesystem::temp_directory_path() / "ptit_bench.ppm";
+      harness.Run("create_image" + suffix, size, [&](Timer&) {
+        CreateImage(path.c_str(), canvas, ImageFormat::kPPM);
+        return Work{static_cast<size_t>(size) * size, drawing.PrimitivesNum()};
+      });
+      std::filesystem::remove(path);
+    }
+
+    if (harness.Selected("binarize" + suffix)) {
+      Canvas canvas(size, size, false, {255, 255, 255});
+      for (const auto& segment : drawing.segments) {
+        canvas.DrawSmooth(segment, {0, 0, 0});
+      }
+      for (const auto& circle : drawing.circles) {
+        canvas.DrawSmooth(circle, {0, 0, 0});
+      }
+      PixelView view = {canvas.Row(0), size, size, canvas.Stride(),
+                        canvas.ChannelsNum()};
+      const std::pair<const char*, ThresholdMode> kModes[] = {
+          {"binarize_fixed", ThresholdMode::kFixed},
+          {"binarize_otsu", ThresholdMode::kOtsu},
+          {"binarize_adaptive", ThresholdMode::kAdaptiveMean}};
+      for (const auto& [name, mode] : kModes) {
+        BinarizeParams params;
+        params.mode = mode;
+        params.threads = options.threads;
+        harness.Run(name + suffix, size, [&](Timer&) {
+          Binarize(view, params);
+          return Work{static_cast<size_t>(size) * size,
+                      drawing.PrimitivesNum()};
+        });
+      }
+    }
+
+    if (harness.Selected("extract" + suffix)) {
+      auto bitmap = Render(drawing, size);
+      size_t pixels = bitmap.Count();
+      ExtractParams params;
+      params.threads = options.threads;
+      params.split_components = options.threads > 1;
+      harness.Run("extract" + suffix, size, [&](Timer& timer) {
+        timer.Pause();
+        auto copy = bitmap;
+        timer.Resume();
+        return Work{pixels, BaseExtractPrimitives(copy, params).size()};
+      });
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  auto options = ParseOptions(argc, argv);
+  Harness harness(options.filter, options.min_time);
+
+  for (int size = 256; size <= options.max_size; size *= 4) {
+    RunSize(harness, options, size);
+  }
+
+  if (options.out.empty()) {
+    harness.WriteJson(std::cout);
+  } else {
+    std::ofstream out(options.out);
+    harness.WriteJson(out);
+  }
+  return 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <array>
+#include <cstddef>
+
+#include "bitmap.hpp"
+
+namespace PTIT {
+
+class NetpbmImage;
+
+// 8-bit pixels of channels interleaved samples: gray, RGB or RGBA, whose
+// alpha is ignored. Row y starts stride bytes after row y - 1, the stride may
+// be negative, so a Canvas or a NetpbmImage is seen as is.
+struct PixelView {
+  const uint8_t* data;
+  int size_x;
+  int size_y;
+  ptrdiff_t stride;
+  int channels = 1;
+
+  const uint8_t* Row(int y) const { return data + y * stride; }
+};
+
+enum class ThresholdMode {
+  kFixed,
+  // global threshold maximizing the variance between the two classes
+  kOtsu,
+  // mean of the neighbouring tiles, bilinearly interpolated between their
+  // centers
+  kAdaptiveMean
+};
+
+struct BinarizeParams {
+  ThresholdMode mode = ThresholdMode::kOtsu;
+  // kFixed: pixels at most this bright are dark
+  int threshold = 127;
+  // kAdaptiveMean: pixels are dark below the local mean minus the offset and
+  // light above the mean plus it
+  int tile_size = 32;
+  int offset = 8;
+  // set pixels are the dark ones, the light ones otherwise
+  bool dark_foreground = true;
+  // number of threads working on row bands, the calling one included
+  int threads = 1;
+};
+
+using Histogram = std::array<size_t, 256>;
+
+// the brightest level of the dark class
+int OtsuThreshold(const Histogram& histogram);
+
+// Color pixels are reduced to their BT.601 luma in 8-bit fixed point, then
+// compared against the threshold 16 pixels at a time when SSE2 is there.
+Bitmap Binarize(const PixelView& view, const BinarizeParams& params = {});
+// bilevel images are taken as they are, with their black pixels set
+Bitmap Binarize(const NetpbmImage& image, const BinarizeParams& params = {});
+
+}  // namespace PTIT
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace PTIT {
+
+// Row-major packed bitmap: bit x of row y lives in word x / 64 of that row,
+// least significant bit first. Rows are padded to a whole cache line, padding
+// bits are always zero.
+class Bitmap {
+ public:
+  using Word = uint64_t;
+
+  static constexpr int kWordBits = 64;
+  static constexpr int kStrideAlignment = 8;
+
+  Bitmap() = default;
+  Bitmap(int size_x, int size_y);
+
+  int SizeX() const { return size_x_; }
+  int SizeY() const { return size_y_; }
+  ptrdiff_t Stride() const { return stride_; }
+  bool Empty() const { return size_x_ == 0 || size_y_ == 0; }
+
+  Word* Row(int y) { return words_.data() + y * stride_; }
+  const Word* Row(int y) const { return words_.data() + y * stride_; }
+
+  bool Get(int x, int y) const {
+    return ((Row(y)[x / kWordBits] >> (x % kWordBits)) & 1) != 0;
+  }
+  void Set(int x, int y) {
+    Row(y)[x / kWordBits] |= Word(1) << (x % kWordBits);
+  }
+  void Reset(int x, int y) {
+    Row(y)[x / kWordBits] &= ~(Word(1) << (x % kWordBits));
+  }
+  void Assign(int x, int y, bool value) { value ? Set(x, y) : Reset(x, y); }
+  // sets [x_begin, x_end) of row y
+  void SetRange(int y, int x_begin, int x_end);
+  // resets [x_begin, x_end) of row y
+  void ResetRange(int y, int x_begin, int x_end);
+
+  // searches for the first set pixel starting from (x, y) in row-major order
+  bool FindNext(int& x, int& y) const;
+  // searches for the first set pixel of row y in [x, x_end)
+  bool FindNextInRow(int& x, int y, int x_end) const;
+  // the first unset pixel of row y from x on, SizeX() if there is none
+  int FindRunEnd(int x, int y) const;
+  size_t Count() const;
+  void Clear();
+  // makes the bitmap size_x by size_y and clears it, the storage is kept when
+  // it is large enough
+  void Reshape(int size_x, int size_y);
+  // words the storage holds without growing
+  size_t Capacity() const { return words_.capacity(); }
+
+ private:
+  int size_x_ = 0;
+  int size_y_ = 0;
+  ptrdiff_t stride_ = 0;
+  std::vector<Word> words_;
+};
+
+// Packs size_x pixels, pixel_stride elements apart, into a Bitmap row; set
+// pixels are the ones converting to true. Contiguous bytes are packed eight
+// at a time.
+template <typename Pixel>
+void PackRow(const Pixel* pixels, ptrdiff_t pixel_stride, int size_x,
+             Bitmap::Word* row) {
+  for (int x_word = 0; x_word < size_x; x_word += Bitmap::kWordBits) {
+    int x_end = std::min(x_word + Bitmap::kWordBits, size_x);
+    Bitmap::Word word = 0;
+    int x = x_word;
+    if constexpr (sizeof(Pixel) == 1 && std::is_integral_v<Pixel>) {
+      for (; pixel_stride == 1 && x + 8 <= x_end; x += 8) {
+        uint64_t bytes = 0;
+        for (int byte = 0; byte < 8; ++byte) {
+          bytes |= uint64_t(static_cast<uint8_t>(pixels[x + byte]))
+                   << (8 * byte);
+        }
+        // the high bits of the nonzero bytes, gathered into the top byte by
+        // the multiplication
+        uint64_t low = (bytes & 0x7F7F7F7F7F7F7F7F) + 0x7F7F7F7F7F7F7F7F;
+        uint64_t nonzero = (low | bytes) & 0x8080808080808080;
+        word |= ((nonzero >> 7) * 0x0102040810204080 >> 56) << (x - x_word);
+      }
+    }
+    for (; x < x_end; ++x) {
+      word |= Bitmap::Word(static_cast<bool>(pixels[x * pixel_stride]))
+              << (x - x_word);
+    }
+    row[x_word / Bitmap::kWordBits] = word;
+  }
+}
+
+}  // namespace PTIT
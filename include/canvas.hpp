@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "image-creator.hpp"
+#include "primitives.hpp"
+#include "span-area.hpp"
+
+namespace PTIT {
+
+// Framebuffer of packed RGB or RGBA pixels. Row y starts at Row(y), rows are
+// Stride() bytes apart and row 0 is the bottom one, as in CreateImage.
+// Primitives are painted in the order they are drawn, pixels out of the
+// canvas are clipped.
+class Canvas {
+ public:
+  Canvas(int size_x, int size_y, bool has_alpha = false,
+         const RGBA& background = {0, 0, 0});
+
+  int SizeX() const { return size_x_; }
+  int SizeY() const { return size_y_; }
+  int ChannelsNum() const { return channels_num_; }
+  bool HasAlpha() const { return channels_num_ == 4; }
+  ptrdiff_t Stride() const { return stride_; }
+
+  uint8_t* Row(int y) { return pixels_.data() + y * stride_; }
+  const uint8_t* Row(int y) const { return pixels_.data() + y * stride_; }
+
+  RGBA GetPixel(int x, int y) const;
+  void Plot(const Coord& point, const RGBA& color);
+  void Clear(const RGBA& color);
+  // paints [x_begin, x_end) of row y
+  void FillSpan(int y, int x_begin, int x_end, const RGBA& color);
+
+  void Draw(const Segment& segment, const RGBA& color);
+  void Draw(const Triangle& triangle, const RGBA& color);
+  void Draw(const Circe& circle, const RGBA& color);
+  void Draw(const Primitive& primitive, const RGBA& color);
+
+  // filled disc
+  void Fill(const Circe& circle, const RGBA& color);
+  // filled triangle, adjacent ones never overlap
+  void Fill(const Triangle& triangle, const RGBA& color);
+  // thick segment, see Segment::GetArea
+  void Fill(const Segment& segment, int radius, const RGBA& color);
+  void Fill(const SpanArea& area, const RGBA& color);
+
+  // Anti-aliased drawing: pixels are blended source over with the color,
+  // its alpha scaled by their coverage. Colors are interpolated and the
+  // alpha of the canvas, if any, accumulates.
+  void Blend(const Coord& point, uint8_t coverage, const RGBA& color);
+  // blends [x_begin, x_end) of row y, coverage[i] is the one of x_begin + i
+  void BlendSpan(int y, int x_begin, int x_end, const uint8_t* coverage,
+                 const RGBA& color);
+
+  void DrawSmooth(const Segment& segment, const RGBA& color);
+  void DrawSmooth(const Circe& circle, const RGBA& color);
+  void FillSmooth(const Segment& segment, int radius, const RGBA& color);
+  void FillSmooth(const Circe& circle, const RGBA& color);
+
+  template <typename Primitives>
+    requires requires(const Primitives& primitives) {
+      primitives.begin();
+      primitives.end();
+    }
+  void Draw(const Primitives& primitives, const RGBA& color) {
+    for (const auto& primitive : primitives) {
+      Draw(primitive, color);
+    }
+  }
+
+ private:
+  int size_x_;
+  int size_y_;
+  int channels_num_;
+  ptrdiff_t stride_;
+  std::vector<uint8_t> pixels_;
+
+  void PutPixel(int x, int y, const RGBA& color) {
+    uint8_t* pixel = Row(y) + x * channels_num_;
+    pixel[0] = static_cast<uint8_t>(color.red);
+    pixel[1] = static_cast<uint8_t>(color.green);
+    pixel[2] = static_cast<uint8_t>(color.blue);
+    if (channels_num_ == 4) {
+      pixel[3] = static_cast<uint8_t>(color.alpha);
+    }
+  }
+  bool Contains(int x, int y) const {
+    return x >= 0 && y >= 0 && x < size_x_ && y < size_y_;
+  }
+};
+
+void CreateImage(const char* image_file, const Canvas& canvas,
+                 ImageFormat format = ImageFormat::kPPM);
+
+}  // namespace PTIT
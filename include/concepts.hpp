@@ -1,6 +1,9 @@
 #pragma once
 
 #include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
 
 namespace PTIT {
 
@@ -13,15 +16,36 @@ concept UnifiedTranslator =
 template <typename Container, typename Checker>
 concept AvailabilityTranslator =
     requires(Container container, Checker checker) {
-      UnifiedTranslator<Container, Checker>;
+      requires UnifiedTranslator<Container, Checker>;
       static_cast<bool>(
           checker(container, std::declval<int>(), std::declval<int>()));
     };
 
 template <typename Container, typename Translator>
 concept RGBTranslator = requires(Container container, Translator translator) {
-  UnifiedTranslator<Container, Translator>;
+  requires UnifiedTranslator<Container, Translator>;
   translator(container, std::declval<int>(), std::declval<int>());
 };
 
-}  // namespace PTIT
\ No newline at end of file
+// Rank 2 view in the manner of std::mdspan, which satisfies it: pixel (x, y)
+// is data_handle()[y * stride(0) + x * stride(1)], extent(0) rows of
+// extent(1) pixels.
+template <typename View>
+concept PixelGrid = requires(const View& view) {
+  requires View::rank() == 2;
+  requires std::is_pointer_v<decltype(view.data_handle())>;
+  { view.extent(0) } -> std::convertible_to<size_t>;
+  { view.stride(0) } -> std::convertible_to<ptrdiff_t>;
+};
+
+template <PixelGrid View>
+using GridPixel = std::remove_cvref_t<
+    decltype(*std::declval<const View&>().data_handle())>;
+
+template <typename View>
+concept AvailabilityGrid =
+    PixelGrid<View> && requires(const GridPixel<View>& pixel) {
+      static_cast<bool>(pixel);
+    };
+
+}  // namespace PTIT
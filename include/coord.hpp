@@ -0,0 +1,28 @@
+#pragma once
+
+namespace PTIT {
+
+struct Coord {
+  int x;
+  int y;
+
+  Coord operator*(float coef) const;
+  Coord operator/(float coef) const;
+};
+
+bool operator==(const Coord&, const Coord&) noexcept;
+bool operator!=(const Coord& first, const Coord& second) noexcept;
+bool operator<(const Coord& first, const Coord& second) noexcept;
+bool operator<=(const Coord& first, const Coord& second) noexcept;
+bool operator>(const Coord& first, const Coord& second) noexcept;
+bool operator>=(const Coord& first, const Coord& second) noexcept;
+
+double GetDistance(const Coord& first, const Coord& second) noexcept;
+
+// pixels [begin.x, end.x) x [begin.y, end.y)
+struct Rect {
+  Coord begin;
+  Coord end;
+};
+
+}  // namespace PTIT
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "bitmap.hpp"
+#include "concepts.hpp"
+#include "coord.hpp"
+#include "primitives.hpp"
+
+namespace PTIT {
+
+// Extraction from a stream of frames of one size, such as video. The working
+// buffers, list nodes and threads are kept from one frame to the next, so once
+// they have grown to the needs of the frames, extracting allocates nothing.
+// The threads share the list nodes, whichever tiles or components they get,
+// but every one grows its own buffers, so with several threads it takes a few
+// frames more to get there. One frame is extracted at a time.
+class Extractor {
+ public:
+  Extractor(int size_x, int size_y, const ExtractParams& params = {});
+  ~Extractor();
+
+  Extractor(Extractor&&) noexcept;
+  Extractor& operator=(Extractor&&) noexcept;
+
+  int SizeX() const { return frame_.SizeX(); }
+  int SizeY() const { return frame_.SizeY(); }
+
+  // The pixels of the frame are cleared on the way. The segments are the
+  // ones of BaseExtractPrimitives, valid until the next call.
+  const std::vector<Segment>& Extract(Bitmap& frame);
+
+  // rows of the grid are packed into a frame kept for it
+  template <AvailabilityGrid View>
+  const std::vector<Segment>& Extract(const View& view) {
+    if (static_cast<int>(view.extent(1)) != SizeX() ||
+        static_cast<int>(view.extent(0)) != SizeY()) {
+      throw std::runtime_error("Frame size mismatch");
+    }
+    auto row_stride = static_cast<ptrdiff_t>(view.stride(0));
+    auto pixel_stride = static_cast<ptrdiff_t>(view.stride(1));
+    for (int y = 0; y < SizeY(); ++y) {
+      PackRow(view.data_handle() + y * row_stride, pixel_stride, SizeX(),
+              frame_.Row(y));
+    }
+    return Extract(frame_);
+  }
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+  Bitmap frame_;
+
+  static std::unique_ptr<Impl> MakeImpl(const Coord& size,
+                                        const ExtractParams& params);
+};
+
+// Extraction kept up to date with an image edited a few pixels at a time.
+// The segments of every 8-connected component are kept apart, and an update
+// extracts again only the components having a pixel in a dirty rectangle or
+// next to it, so its cost is the one of the edited components, not of the
+// image. They are extracted whole, however few of their pixels changed: an
+// edit of a component spanning most of the image costs about a full
+// extraction, which an update falls back to once the edited components hold
+// a quarter of the image runs. The segments are the ones of
+// BaseExtractPrimitives with split_components, the same as without it;
+// tile_size, threads and stats are ignored.
+class IncrementalExtractor {
+ public:
+  explicit IncrementalExtractor(const Bitmap& image,
+                                const ExtractParams& params = {});
+  ~IncrementalExtractor();
+
+  IncrementalExtractor(IncrementalExtractor&&) noexcept;
+  IncrementalExtractor& operator=(IncrementalExtractor&&) noexcept;
+
+  // the pixels of the image kept up to date
+  const Bitmap& Image() const;
+
+  // The pixels of image in the dirty rectangles replace the kept ones, the
+  // other pixels of image are not read. Rectangles are clipped to the image.
+  void Update(const Bitmap& image, const std::vector<Rect>& dirty);
+
+  std::list<Segment> Segments() const;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace PTIT
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+namespace PTIT {
+
+// The part of std::mdspan the library needs, for standards without it: rows
+// of pixels stride(0) elements apart, that may be negative.
+template <typename Pixel>
+class GridView {
+ public:
+  GridView(Pixel* data, size_t size_x, size_t size_y)
+      : GridView(data, size_x, size_y, static_cast<ptrdiff_t>(size_x)) {}
+  GridView(Pixel* data, size_t size_x, size_t size_y, ptrdiff_t row_stride,
+           ptrdiff_t pixel_stride = 1)
+      : data_(data),
+        extents_{size_y, size_x},
+        strides_{row_stride, pixel_stride} {}
+
+  static constexpr size_t rank() { return 2; }
+
+  Pixel* data_handle() const { return data_; }
+  size_t extent(size_t rank) const { return extents_[rank]; }
+  ptrdiff_t stride(size_t rank) const { return strides_[rank]; }
+
+  Pixel& operator()(size_t y, size_t x) const {
+    return data_[static_cast<ptrdiff_t>(y) * strides_[0] +
+                 static_cast<ptrdiff_t>(x) * strides_[1]];
+  }
+
+ private:
+  Pixel* data_;
+  size_t extents_[2];
+  ptrdiff_t strides_[2];
+};
+
+}  // namespace PTIT
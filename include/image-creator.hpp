@@ -1,45 +1,165 @@
 #pragma once
 
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <array>
 #include <fstream>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 #include "concepts.hpp"
 #include "primitives.hpp"
 
 namespace PTIT {
 
+struct RGB {
+  short red;
+  short green;
+  short blue;
+
+  static const int kMaxColor = 255;
+};
+
+struct RGBA {
+  short red;
+  short green;
+  short blue;
+  short alpha = kMaxColor;
+
+  static const int kMaxColor = 255;
+};
+
+bool operator==(const RGB&, const RGB&) noexcept;
+bool operator==(const RGBA&, const RGBA&) noexcept;
+
+enum class ImageFormat {
+  // ASCII RGB, P3
+  kPlainPPM,
+  // binary RGB, P6
+  kPPM,
+  // binary grayscale, P5
+  kPGM,
+  // binary RGB with alpha, P7
+  kPAM
+};
+
+// Writes an image row by row, from the top one. Rows are packed bytes,
+// ChannelsNum() of them per pixel, and are written in large blocks.
+class ImageWriter {
+ public:
+  ImageWriter(const char* image_file, ssize_t size_x, ssize_t size_y,
+              ImageFormat format);
+  ~ImageWriter();
+
+  ImageWriter(const ImageWriter&) = delete;
+  ImageWriter& operator=(const ImageWriter&) = delete;
+
+  static int ChannelsNum(ImageFormat format);
+  int ChannelsNum() const { return ChannelsNum(format_); }
+
+  void WriteRow(const uint8_t* row);
+  void Close();
+
+ private:
+  static const size_t kBlockSize = 1 << 20;
+
+  std::ofstream img_file_;
+  ssize_t size_x_;
+  ImageFormat format_;
+  std::vector<char> buffer_;
+
+  void Flush();
+};
+
+template <typename Pixel>
+RGBA ToRGBA(const Pixel& pixel) {
+  if constexpr (std::is_arithmetic_v<Pixel>) {
+    auto level = static_cast<short>(pixel);
+    return {level, level, level};
+  } else if constexpr (requires { pixel.alpha; }) {
+    return {static_cast<short>(pixel.red), static_cast<short>(pixel.green),
+            static_cast<short>(pixel.blue), static_cast<short>(pixel.alpha)};
+  } else if constexpr (requires {
+                         requires std::tuple_size<Pixel>::value == 4;
+                       }) {
+    const auto& [red, green, blue, alpha] = pixel;
+    return {static_cast<short>(red), static_cast<short>(green),
+            static_cast<short>(blue), static_cast<short>(alpha)};
+  } else {
+    const auto& [red, green, blue] = pixel;
+    return {static_cast<short>(red), static_cast<short>(green),
+            static_cast<short>(blue)};
+  }
+}
+
+// stores a pixel in the layout of the format, returns the next position
+uint8_t* PackPixel(const RGBA& pixel, ImageFormat format, uint8_t* dest);
+
 template <typename Container, typename Translator>
   requires RGBTranslator<Container, Translator>
 void CreateImage(const char* image_file, const Container& image, ssize_t size_x,
-                 ssize_t size_y, Translator translator) {
-  std::ofstream img_file(image_file);
-  if (!img_file.is_open()) {
-    throw std::runtime_error("Cannot open file");
-  }
-
-  img_file << "P3"
-           << "\n";
-  img_file << size_x << " " << size_y << "\n";
-  img_file << "255"
-           << "\n";
+                 ssize_t size_y, Translator translator,
+                 ImageFormat format = ImageFormat::kPlainPPM) {
+  ImageWriter writer(image_file, size_x, size_y, format);
+  std::vector<uint8_t> row(size_x * writer.ChannelsNum());
 
   for (ssize_t y = size_y - 1; y >= 0; --y) {
+    auto* dest = row.data();
     for (ssize_t x = 0; x < size_x; ++x) {
-      const auto& [red, green, blue] = translator(image, x, y);
-      img_file << red << " " << green << " " << blue << "\n";
+      dest = PackPixel(ToRGBA(translator(image, x, y)), format, dest);
     }
+    writer.WriteRow(row.data());
   }
 
-  img_file.close();
+  writer.Close();
 }
 
-struct RGB {
-  short red;
-  short green;
-  short blue;
+// bytes of a pixel when it is laid out as an image format stores it, 0
+// otherwise
+template <typename Pixel>
+inline constexpr int kPackedPixelSize = 0;
+template <>
+inline constexpr int kPackedPixelSize<uint8_t> = 1;
+template <size_t kChannels>
+inline constexpr int kPackedPixelSize<std::array<uint8_t, kChannels>> =
+    static_cast<int>(kChannels);
 
-  static const int kMaxColor = 255;
-};
+// Row 0 of the grid is the bottom one. Rows of contiguous pixels already in
+// the layout of the format are written as they are, the others are packed a
+// row at a time.
+template <PixelGrid View>
+void CreateImage(const char* image_file, const View& view,
+                 ImageFormat format = ImageFormat::kPPM) {
+  using Pixel = GridPixel<View>;
+  auto size_x = static_cast<ssize_t>(view.extent(1));
+  auto size_y = static_cast<ssize_t>(view.extent(0));
+  auto row_stride = static_cast<ptrdiff_t>(view.stride(0));
+  auto pixel_stride = static_cast<ptrdiff_t>(view.stride(1));
 
-bool operator==(const RGB&, const RGB&) noexcept;
+  ImageWriter writer(image_file, size_x, size_y, format);
+  bool same_layout =
+      kPackedPixelSize<Pixel> == writer.ChannelsNum() && pixel_stride == 1;
+  std::vector<uint8_t> row(same_layout ? 0 : size_x * writer.ChannelsNum());
+
+  for (ssize_t y = size_y - 1; y >= 0; --y) {
+    const auto* pixels = view.data_handle() + y * row_stride;
+    if constexpr (kPackedPixelSize<Pixel> != 0) {
+      if (same_layout) {
+        writer.WriteRow(reinterpret_cast<const uint8_t*>(pixels));
+        continue;
+      }
+    }
+    auto* dest = row.data();
+    for (ssize_t x = 0; x < size_x; ++x) {
+      dest = PackPixel(ToRGBA(pixels[x * pixel_stride]), format, dest);
+    }
+    writer.WriteRow(row.data());
+  }
+
+  writer.Close();
+}
 
 }  // namespace PTIT
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <list>
+#include <vector>
+
+#include "bitmap.hpp"
+#include "primitives.hpp"
+
+namespace PTIT {
+
+// Read-only mapping of a whole file.
+class MappedFile {
+ public:
+  explicit MappedFile(const char* file);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const uint8_t* Data() const { return data_; }
+  size_t Size() const { return size_; }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Netpbm image, P1 to P6. The raster of a binary file is a view into the
+// mapped file, plain ones are parsed once into the layout of the binary
+// format of the same kind. Rows are numbered from the bottom one, as
+// CreateImage writes them.
+class NetpbmImage {
+ public:
+  explicit NetpbmImage(const char* image_file);
+
+  int SizeX() const { return size_x_; }
+  int SizeY() const { return size_y_; }
+  // 1 for bilevel images
+  int MaxValue() const { return max_value_; }
+  int ChannelsNum() const { return channels_; }
+  bool Bilevel() const { return bilevel_; }
+
+  // row y in the binary layout: bits of a bilevel image, most significant
+  // first and set for black, or samples of the channels, big-endian words
+  // when MaxValue() exceeds 255
+  const uint8_t* Row(int y) const {
+    return raster_ + static_cast<size_t>(size_y_ - 1 - y) * row_bytes_;
+  }
+  size_t RowBytes() const { return row_bytes_; }
+  int Sample(int x, int y, int channel = 0) const;
+
+  // packs the black pixels of row y of a bilevel image as Bitmap rows are,
+  // whole bytes at a time; a row producer of StreamExtractPrimitives as is,
+  // which asks for the rows in the order of the file
+  void PackRow(int y, Bitmap::Word* row) const;
+  Bitmap ToBitmap() const;
+
+ private:
+  MappedFile file_;
+  std::vector<uint8_t> plain_raster_;
+  const uint8_t* raster_ = nullptr;
+  int size_x_ = 0;
+  int size_y_ = 0;
+  int max_value_ = 1;
+  int channels_ = 1;
+  bool bilevel_ = false;
+  size_t row_bytes_ = 0;
+
+  void ParsePlain(const uint8_t* begin, const uint8_t* end);
+};
+
+// black pixels of a bilevel image, rows go to the bitmap without a
+// translator call per pixel; other images are binarized with Otsu's threshold
+std::list<Segment> ExtractPrimitives(const NetpbmImage& image,
+                                     const ExtractParams& params = {});
+
+}  // namespace PTIT
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <ranges>
+#include <vector>
+
+#include "coord.hpp"
+#include "primitives.hpp"
+
+namespace PTIT {
+
+// Primitives as structures of arrays, a coordinate of every primitive in an
+// array, so that the kernels below go over whole arrays, several primitives
+// at a time when SSE2 is there. The kernels give the same coordinates as the
+// operations of Coord and of the primitives applied one by one.
+
+// segment i goes from (a_x[i], a_y[i]) to (b_x[i], b_y[i])
+struct SegmentBatch {
+  std::vector<int> a_x;
+  std::vector<int> a_y;
+  std::vector<int> b_x;
+  std::vector<int> b_y;
+
+  SegmentBatch() = default;
+  template <std::ranges::input_range Segments>
+  explicit SegmentBatch(const Segments& segments) {
+    for (const Segment& segment : segments) {
+      Add(segment);
+    }
+  }
+
+  size_t Size() const { return a_x.size(); }
+  void Add(const Segment& segment);
+  Segment Get(size_t index) const;
+  void Set(size_t index, const Segment& segment);
+  std::list<Segment> ToList() const;
+};
+
+struct TriangleBatch {
+  std::vector<int> a_x;
+  std::vector<int> a_y;
+  std::vector<int> b_x;
+  std::vector<int> b_y;
+  std::vector<int> c_x;
+  std::vector<int> c_y;
+
+  TriangleBatch() = default;
+  template <std::ranges::input_range Triangles>
+  explicit TriangleBatch(const Triangles& triangles) {
+    for (const Triangle& triangle : triangles) {
+      Add(triangle);
+    }
+  }
+
+  size_t Size() const { return a_x.size(); }
+  void Add(const Triangle& triangle);
+  Triangle Get(size_t index) const;
+};
+
+struct CirceBatch {
+  std::vector<int> center_x;
+  std::vector<int> center_y;
+  std::vector<int> radius;
+
+  CirceBatch() = default;
+  template <std::ranges::input_range Circes>
+  explicit CirceBatch(const Circes& circes) {
+    for (const Circe& circe : circes) {
+      Add(circe);
+    }
+  }
+
+  size_t Size() const { return center_x.size(); }
+  void Add(const Circe& circe);
+  Circe Get(size_t index) const;
+};
+
+// every point times coef as Coord::operator* does it, radii too
+void Scale(SegmentBatch& batch, float coef);
+void Scale(TriangleBatch& batch, float coef);
+void Scale(CirceBatch& batch, float coef);
+
+void Translate(SegmentBatch& batch, const Coord& offset);
+void Translate(TriangleBatch& batch, const Coord& offset);
+void Translate(CirceBatch& batch, const Coord& offset);
+
+// every point turned by deg from the x axis toward the y one around center,
+// rounded to the nearest
+void Rotate(SegmentBatch& batch, const Coord& center, double deg);
+void Rotate(TriangleBatch& batch, const Coord& center, double deg);
+void Rotate(CirceBatch& batch, const Coord& center, double deg);
+
+// of the points, radii around centers included; empty for an empty batch
+Rect GetBounds(const SegmentBatch& batch);
+Rect GetBounds(const TriangleBatch& batch);
+Rect GetBounds(const CirceBatch& batch);
+
+// GetDistance between the ends, Segment::GetAngle, SetLen and SetAngle of
+// every segment; the arctangents of GetAngle are left to the math library,
+// one segment at a time
+void GetLengths(const SegmentBatch& batch, std::vector<double>& lengths);
+void GetAngles(const SegmentBatch& batch, std::vector<double>& angles);
+void SetLen(SegmentBatch& batch, int len);
+void SetAngle(SegmentBatch& batch, double deg);
+
+}  // namespace PTIT
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <fstream>
+#include <vector>
+
+#include "coord.hpp"
+#include "image-reader.hpp"
+#include "primitives.hpp"
+
+namespace PTIT {
+
+// Primitive file, version 1, little-endian:
+//   header   "PTITPRIM", version u32, reserved u32
+//   blocks   primitives of one kind each, in the order they were written
+//   index    per block: kind u32, count u32, offset u64, size u64, bounds
+//            4 x i32
+//   trailer  index offset u64, blocks u32, "PEND"
+// Inside a block, primitives are sorted along a Z-order curve by their first
+// point (the center of a circle). A primitive is stored as varints of
+// zigzagged differences: its first point from the one of the previous
+// primitive, then its other points from its first one, or the radius.
+// Every block starts from (0, 0), so it can be decoded on its own.
+
+enum class PrimitiveKind : uint32_t { kSegment, kTriangle, kCirce };
+
+struct PrimitiveBlock {
+  PrimitiveKind kind;
+  uint32_t count;
+  // bytes of the block in the file
+  uint64_t offset;
+  uint64_t size;
+  // the points of the primitives, radii around centers included
+  Rect bounds;
+};
+
+// Writes primitives as they come, like the segments of
+// StreamExtractPrimitives. A block of a kind is written once block_size
+// primitives of the kind are pending, so only those are kept.
+class PrimitiveWriter {
+ public:
+  static const int kDefaultBlockSize = 4096;
+
+  explicit PrimitiveWriter(const char* file,
+                           int block_size = kDefaultBlockSize);
+  ~PrimitiveWriter();
+
+  PrimitiveWriter(const PrimitiveWriter&) = delete;
+  PrimitiveWriter& operator=(const PrimitiveWriter&) = delete;
+
+  void Add(const Segment& segment);
+  void Add(const Triangle& triangle);
+  void Add(const Circe& circe);
+
+  // writes the pending blocks and the index, without which the file is not
+  // readable
+  void Close();
+
+ private:
+  std::ofstream file_;
+  size_t block_size_;
+  uint64_t offset_ = 0;
+  std::vector<Segment> segments_;
+  std::vector<Triangle> triangles_;
+  std::vector<Circe> circes_;
+  std::vector<PrimitiveBlock> blocks_;
+  std::vector<char> buffer_;
+
+  template <typename Primitive>
+  void WriteBlock(std::vector<Primitive>& primitives);
+  void Finish();
+};
+
+// Primitive file mapped in memory. Opening it reads the index only, blocks
+// are decoded when asked for.
+class PrimitiveReader {
+ public:
+  explicit PrimitiveReader(const char* file);
+
+  const std::vector<PrimitiveBlock>& Blocks() const { return blocks_; }
+  // of all the blocks, empty when there are none
+  Rect Bounds() const;
+
+  // appends the primitives of a block, which must be of their kind
+  void ReadBlock(size_t index, std::vector<Segment>& segments) const;
+  void ReadBlock(size_t index, std::vector<Triangle>& triangles) const;
+  void ReadBlock(size_t index, std::vector<Circe>& circes) const;
+
+  // appends the primitives of the kind whose bounds meet the area, decoding
+  // only the blocks whose bounds meet it; Query(Bounds(), ...) reads them all
+  void Query(const Rect& area, std::vector<Segment>& segments) const;
+  void Query(const Rect& area, std::vector<Triangle>& triangles) const;
+  void Query(const Rect& area, std::vector<Circe>& circes) const;
+
+ private:
+  MappedFile file_;
+  std::vector<PrimitiveBlock> blocks_;
+
+  template <typename Primitive>
+  void Decode(size_t index, const Rect* area,
+              std::vector<Primitive>& primitives) const;
+};
+
+}  // namespace PTIT
@@ -1,30 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
+#include <iosfwd>
 #include <list>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
+#include "bitmap.hpp"
 #include "concepts.hpp"
+#include "coord.hpp"
+#include "grid-view.hpp"
+#include "span-area.hpp"
 
 namespace PTIT {
 
-struct Coord {
-  int x;
-  int y;
-
-  Coord operator*(float coef) const;
-  Coord operator/(float coef) const;
-};
-
-bool operator==(const Coord&, const Coord&) noexcept;
-bool operator!=(const Coord& first, const Coord& second) noexcept;
-bool operator<(const Coord& first, const Coord& second) noexcept;
-bool operator<=(const Coord& first, const Coord& second) noexcept;
-bool operator>(const Coord& first, const Coord& second) noexcept;
-bool operator>=(const Coord& first, const Coord& second) noexcept;
-
-double GetDistance(const Coord& first, const Coord& second) noexcept;
-
 double DegToRad(double deg);
 double RadToDeg(double rad);
 double TanToDeg(double tan);
@@ -50,13 +43,13 @@ class Segment : public Primitive {
   void SetAngle(double deg);
 
   std::list<Coord> GetGraphic() const override;
-  std::list<Coord> GetArea(int radius) const;
+  // pixels at most radius + 1/2 away from the segment
+  SpanArea GetArea(int radius) const;
 
  private:
   Coord a_point_;
   Coord b_point_;
 
-  int GetBCoefficient() const;
   Coord GetCenter() const;
   void SetKCoef(double new_k);
 };
@@ -69,6 +62,8 @@ class Triangle : public Primitive {
   std::tuple<Coord, Coord, Coord> GetPoints() const;
 
   std::list<Coord> GetGraphic() const override;
+  // filled triangle, see ForEachSpan
+  SpanArea GetArea() const;
 
  private:
   Coord a_point_;
@@ -87,30 +82,170 @@ class Circe : public Primitive {
   int GetRadius() const;
 
   std::list<Coord> GetGraphic() const override;
+  // filled disc
+  SpanArea GetArea() const;
 
  private:
   Coord center_;
   int radius_;
 };
 
-std::list<Coord> FulfillArea(const std::list<Coord>& border);
+// fills every row of the border from its leftmost to its rightmost point
+SpanArea FulfillArea(const std::list<Coord>& border);
+SpanArea FulfillArea(const std::vector<Coord>& border);
 
-std::list<Segment> BaseExtractPrimitives(
-    std::vector<std::vector<bool>>& bitmap);
+enum class KRangeMode {
+  // exact integer slope ranges
+  kCone,
+  // floating point slope ranges with a small tolerance, kept to compare
+  // results with the former implementation
+  kReference
+};
+
+// order in which set pixels seed the traversal; segments grow from the seeds
+// greedily, so the order changes the result
+enum class SeedOrder {
+  // row by row from y = 0, left to right; set pixels are found a word at a
+  // time
+  kRows,
+  // column by column from x = 0, from y = 0 up, the order of the former
+  // implementation, kept so that its callers get the same segments
+  kColumns
+};
+
+// time a thread spent in a phase of the extraction of a region: "components"
+// (labelling), "traversal" (raw segments), "deviations" (their deviations and
+// restricted moves), "indexing" (the endpoint index), "merging" (joining
+// segments) or "stitching" (joining tiles or strips)
+struct ExtractEvent {
+  const char* phase;
+  int thread;
+  // microseconds from the start of the extraction
+  double start_us;
+  double duration_us;
+};
 
+struct ExtractStats {
+  // heap allocations made by the extraction for its working buffers
+  size_t allocations = 0;
+  size_t allocated_bytes = 0;
+
+  size_t pixels_visited = 0;
+  size_t max_stack_depth = 0;
+  // segments found by the traversal and left after merging
+  size_t raw_segments = 0;
+  size_t segments = 0;
+  // pairs of segments checked for merging and the merged ones
+  size_t merge_attempts = 0;
+  size_t merges = 0;
+
+  // ordered by start
+  std::vector<ExtractEvent> events;
+
+  // wall time of the phase summed over its events, in seconds
+  double PhaseSeconds(std::string_view phase) const;
+  // the events and the counters in the Chrome trace event format
+  void WriteChromeTrace(std::ostream& out) const;
+};
+
+struct ExtractParams {
+  KRangeMode k_range_mode = KRangeMode::kCone;
+  // streaming and incremental extraction always seed by rows
+  SeedOrder seed_order = SeedOrder::kRows;
+  // number of threads working on tiles or components, the calling one
+  // included
+  int threads = 1;
+  // side of the square tiles the bitmap is split into, 0 disables tiling;
+  // the result depends on it, but not on the number of threads
+  int tile_size = 0;
+  // without tiling, extracts every 8-connected component on its own; the
+  // segments are the same as without it, grouped by component in the order
+  // of their first pixels
+  bool split_components = false;
+  // filled in when set, gathering it is compiled out otherwise
+  ExtractStats* stats = nullptr;
+};
+
+std::list<Segment> BaseExtractPrimitives(Bitmap& bitmap,
+                                         const ExtractParams& params = {});
+// bitmap[x][y]; seeds by columns unless told otherwise, as it always did
+std::list<Segment> BaseExtractPrimitives(
+    std::vector<std::vector<bool>>& bitmap,
+    const ExtractParams& params = {.seed_order = SeedOrder::kColumns});
+
+// fills row y of the image packed as in Bitmap, bits past the width are
+// ignored
+using RowProducer = std::function<void(int y, Bitmap::Word* row)>;
+using SegmentSink = std::function<void(const Segment& segment)>;
+
+const int kDefaultStripHeight = 256;
+
+// Streaming extraction: the image is read from row size_y - 1, the top one
+// as in CreateImage, down to row 0, the order scanners and Netpbm files give
+// rows in, so a pipe can feed it directly. It goes in strips of
+// params.tile_size rows (kDefaultStripHeight when it is 0), the first one at
+// the top, and every segment goes to the sink as soon as no later strip can
+// join it. Only the strip and the segments ending on its lowest row are
+// kept, whatever the image height. The result depends on the strip height as
+// it does on the tile size; threads, split_components and seed_order are
+// ignored.
+void StreamExtractPrimitives(int size_x, int size_y, const RowProducer& rows,
+                             const SegmentSink& sink,
+                             const ExtractParams& params = {});
+
+// seeds by columns unless told otherwise, as it always did
 template <typename Container, typename Translator>
   requires AvailabilityTranslator<Container, Translator>
-std::list<Segment> ExtractPrimitives(const Container& container, int size_x,
-                                     int size_y, Translator translator) {
-  std::vector<std::vector<bool>> converted_bitmap(size_x,
-                                                  std::vector<bool>(size_y));
-  for (int x = 0; x < size_x; ++x) {
-    for (int y = 0; y < size_y; ++y) {
-      converted_bitmap[x][y] = static_cast<bool>(translator(container, x, y));
+std::list<Segment> ExtractPrimitives(
+    const Container& container, int size_x, int size_y, Translator translator,
+    const ExtractParams& params = {.seed_order = SeedOrder::kColumns}) {
+  Bitmap converted_bitmap(size_x, size_y);
+  for (int y = 0; y < size_y; ++y) {
+    auto* row = converted_bitmap.Row(y);
+    for (int x_word = 0; x_word < size_x; x_word += Bitmap::kWordBits) {
+      Bitmap::Word word = 0;
+      int x_end = std::min(x_word + Bitmap::kWordBits, size_x);
+      for (int x = x_word; x < x_end; ++x) {
+        word |= static_cast<Bitmap::Word>(
+                    static_cast<bool>(translator(container, x, y)))
+                << (x - x_word);
+      }
+      row[x_word / Bitmap::kWordBits] = word;
     }
   }
 
-  return BaseExtractPrimitives(converted_bitmap);
+  return BaseExtractPrimitives(converted_bitmap, params);
+}
+
+// the rows of a grid are packed whole, without a translator call per pixel
+template <AvailabilityGrid View>
+std::list<Segment> ExtractPrimitives(const View& view,
+                                     const ExtractParams& params = {}) {
+  auto size_x = static_cast<int>(view.extent(1));
+  auto size_y = static_cast<int>(view.extent(0));
+  auto row_stride = static_cast<ptrdiff_t>(view.stride(0));
+  auto pixel_stride = static_cast<ptrdiff_t>(view.stride(1));
+
+  Bitmap converted_bitmap(size_x, size_y);
+  for (int y = 0; y < size_y; ++y) {
+    PackRow(view.data_handle() + y * row_stride, pixel_stride, size_x,
+            converted_bitmap.Row(y));
+  }
+  return BaseExtractPrimitives(converted_bitmap, params);
+}
+
+// row-major pixels: pixel (x, y) is pixels[y * size_x + x]
+template <std::ranges::contiguous_range Pixels>
+  requires AvailabilityGrid<
+      GridView<const std::ranges::range_value_t<Pixels>>>
+std::list<Segment> ExtractPrimitives(const Pixels& pixels, int size_x,
+                                     int size_y,
+                                     const ExtractParams& params = {}) {
+  if (std::ranges::size(pixels) < static_cast<size_t>(size_x) * size_y) {
+    throw std::runtime_error("Not enough pixels");
+  }
+  return ExtractPrimitives(
+      GridView(std::ranges::data(pixels), size_x, size_y), params);
 }
 
 }  // namespace PTIT
\ No newline at end of file
@@ -0,0 +1,666 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <ranges>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "primitives.hpp"
+
+namespace PTIT {
+
+// Integer DDA along a segment: one pixel for every step along the major axis,
+// both ends included, the minor coordinate rounded half away from the start.
+// Pixels go from the lesser end to the greater one.
+class LineStepper {
+ public:
+  LineStepper() = default;
+  LineStepper(Coord a_point, Coord b_point) {
+    if (b_point < a_point) {
+      std::swap(a_point, b_point);
+    }
+    point_ = a_point;
+
+    int delta_x = b_point.x - a_point.x;
+    int delta_y = b_point.y - a_point.y;
+    int y_inc = delta_y >= 0 ? 1 : -1;
+
+    if (std::abs(delta_y) <= delta_x) {
+      major_step_ = {1, 0};
+      minor_step_ = {0, y_inc};
+      major_len_ = delta_x;
+      minor_len_ = std::abs(delta_y);
+    } else {
+      major_step_ = {0, y_inc};
+      minor_step_ = {1, 0};
+      major_len_ = std::abs(delta_y);
+      minor_len_ = delta_x;
+    }
+    left_ = static_cast<int64_t>(major_len_) + 1;
+  }
+
+  const Coord& Point() const { return point_; }
+  // pixels left, the current one included
+  int64_t Left() const { return left_; }
+  bool Done() const { return left_ == 0; }
+
+  void Next() {
+    if (--left_ <= 0) {
+      return;
+    }
+    point_.x += major_step_.x;
+    point_.y += major_step_.y;
+    error_ += 2 * minor_len_;
+    if (error_ >= major_len_) {
+      point_.x += minor_step_.x;
+      point_.y += minor_step_.y;
+      error_ -= 2 * major_len_;
+    }
+  }
+
+ private:
+  Coord point_ = {0, 0};
+  Coord major_step_ = {0, 0};
+  Coord minor_step_ = {0, 0};
+  int64_t major_len_ = 0;
+  int64_t minor_len_ = 0;
+  int64_t error_ = 0;
+  int64_t left_ = 0;
+};
+
+template <typename Visitor>
+void ForEachPixel(const Segment& segment, Visitor&& visitor) {
+  for (LineStepper stepper(segment.GetA(), segment.GetB()); !stepper.Done();
+       stepper.Next()) {
+    visitor(stepper.Point());
+  }
+}
+
+template <typename Visitor>
+void ForEachPixel(const Triangle& triangle, Visitor&& visitor) {
+  const auto& [a_point, b_point, c_point] = triangle.GetPoints();
+  ForEachPixel(Segment(a_point, b_point), visitor);
+  ForEachPixel(Segment(b_point, c_point), visitor);
+  ForEachPixel(Segment(c_point, a_point), visitor);
+}
+
+// Midpoint circle: every pixel of the outline is visited once, the eight
+// octants are produced together from the first one
+template <typename Visitor>
+void ForEachPixel(const Circe& circle, Visitor&& visitor) {
+  const Coord& center = circle.GetCenter();
+  int radius = circle.GetRadius();
+  if (radius <= 0) {
+    visitor(center);
+    return;
+  }
+
+  auto visit = [&center, &visitor](int x, int y) {
+    visitor(Coord{center.x + x, center.y + y});
+  };
+
+  for (int x = 0, y = radius, decision = 1 - radius; x <= y; ++x) {
+    if (x == 0) {
+      visit(0, y);
+      visit(0, -y);
+      visit(y, 0);
+      visit(-y, 0);
+    } else if (x == y) {
+      visit(x, y);
+      visit(-x, y);
+      visit(x, -y);
+      visit(-x, -y);
+    } else {
+      visit(x, y);
+      visit(-x, y);
+      visit(x, -y);
+      visit(-x, -y);
+      visit(y, x);
+      visit(-y, x);
+      visit(y, -x);
+      visit(-y, -x);
+    }
+
+    if (decision < 0) {
+      decision += 2 * x + 3;
+    } else {
+      decision += 2 * (x - y) + 5;
+      --y;
+    }
+  }
+}
+
+// Filled disc bounded by the midpoint circle as spans: visitor(y, x_begin,
+// x_end) is called once for every row, x_end excluded. Rows come in no
+// particular order.
+template <typename Visitor>
+void ForEachSpan(const Circe& circle, Visitor&& visitor) {
+  const Coord& center = circle.GetCenter();
+  int radius = circle.GetRadius();
+  if (radius <= 0) {
+    visitor(center.y, center.x, center.x + 1);
+    return;
+  }
+
+  auto visit_rows = [&center, &visitor](int y, int half_width) {
+    visitor(center.y + y, center.x - half_width, center.x + half_width + 1);
+    if (y != 0) {
+      visitor(center.y - y, center.x - half_width, center.x + half_width + 1);
+    }
+  };
+
+  for (int x = 0, y = radius, decision = 1 - radius; x <= y; ++x) {
+    visit_rows(x, y);
+
+    if (decision < 0) {
+      decision += 2 * x + 3;
+    } else {
+      // the widest pixel of rows +-y is the last one before y changes
+      if (y != x) {
+        visit_rows(y, x);
+      }
+      decision += 2 * (x - y) + 5;
+      --y;
+    }
+  }
+}
+
+// integer square root, rounded down
+inline int64_t ISqrt(int64_t value) {
+  auto root = static_cast<int64_t>(std::sqrt(static_cast<double>(value)));
+  while (root * root > value) {
+    --root;
+  }
+  while ((root + 1) * (root + 1) <= value) {
+    ++root;
+  }
+  return root;
+}
+
+// value / divisor rounded down, divisor > 0
+inline int64_t FloorDiv(int64_t value, int64_t divisor) {
+  return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+// narrows [x_begin, x_end) to the x with coef * x >= low
+inline void ClipHalfLine(int64_t coef, int64_t low, int64_t& x_begin,
+                         int64_t& x_end) {
+  if (coef > 0) {
+    x_begin = std::max(x_begin, -FloorDiv(-low, coef));
+  } else if (coef < 0) {
+    x_end = std::min(x_end, FloorDiv(-low, -coef) + 1);
+  } else if (low > 0) {
+    x_end = x_begin;
+  }
+}
+
+// Thick segment (capsule): every pixel whose center is at most radius + 1/2
+// away from the segment. visitor(y, x_begin, x_end) is called once for every
+// row, x_end excluded, rows go up. Each row is found in closed form as the
+// hull of the rows of the two end discs and of the band between them.
+template <typename Visitor>
+void ForEachSpan(const Segment& segment, int radius, Visitor&& visitor) {
+  const Coord& a_point = segment.GetA();
+  const Coord& b_point = segment.GetB();
+  int64_t width = 2 * static_cast<int64_t>(std::max(radius, 0)) + 1;
+  // squared distances are integers, so d^2 <= (r + 1/2)^2 is d^2 <= r^2 + r
+  int64_t sqr_radius = (width * width - 1) / 4;
+
+  int64_t delta_x = b_point.x - a_point.x;
+  int64_t delta_y = b_point.y - a_point.y;
+  int64_t sqr_len = delta_x * delta_x + delta_y * delta_y;
+  // the band is 0 <= dot(p - a, b - a) <= sqr_len and
+  // |cross(p - a, b - a)| <= max_cross
+  int64_t max_cross = ISqrt(width * width * sqr_len) / 2;
+
+  auto add_disc_row = [sqr_radius](const Coord& center, int64_t y,
+                                   int64_t& x_begin, int64_t& x_end) {
+    int64_t offset = y - center.y;
+    if (offset * offset > sqr_radius) {
+      return;
+    }
+    int64_t half_width = ISqrt(sqr_radius - offset * offset);
+    x_begin = std::min(x_begin, center.x - half_width);
+    x_end = std::max(x_end, center.x + half_width + 1);
+  };
+  int64_t half_rows = (width - 1) / 2;
+  int64_t y_begin = std::min(a_point.y, b_point.y) - half_rows;
+  int64_t y_end = std::max(a_point.y, b_point.y) + half_rows + 1;
+  for (int64_t y = y_begin; y < y_end; ++y) {
+    int64_t x_begin = INT64_MAX;
+    int64_t x_end = INT64_MIN;
+    add_disc_row(a_point, y, x_begin, x_end);
+    add_disc_row(b_point, y, x_begin, x_end);
+
+    if (sqr_len != 0) {
+      // x is taken relative to a_point here
+      int64_t row = y - a_point.y;
+      int64_t band_begin = INT64_MIN;
+      int64_t band_end = INT64_MAX;
+      ClipHalfLine(delta_y, row * delta_x - max_cross, band_begin, band_end);
+      ClipHalfLine(-delta_y, -row * delta_x - max_cross, band_begin,
+                   band_end);
+      ClipHalfLine(delta_x, -row * delta_y, band_begin, band_end);
+      ClipHalfLine(-delta_x, row * delta_y - sqr_len, band_begin, band_end);
+      if (band_begin < band_end) {
+        x_begin = std::min(x_begin, a_point.x + band_begin);
+        x_end = std::max(x_end, a_point.x + band_end);
+      }
+    }
+
+    if (x_begin < x_end) {
+      visitor(static_cast<int>(y), static_cast<int>(x_begin),
+              static_cast<int>(x_end));
+    }
+  }
+}
+
+// Filled triangle as spans, from its edge functions: visitor(y, x_begin,
+// x_end) is called once for every non-empty row, rows go up. A pixel whose
+// center lies on an edge is taken only if the edge is a top or a left one, so
+// triangles sharing an edge never paint it twice and leave no gap along it.
+// Degenerate triangles give no pixels.
+template <typename Visitor>
+void ForEachSpan(const Triangle& triangle, Visitor&& visitor) {
+  auto [a_point, b_point, c_point] = triangle.GetPoints();
+  int64_t double_area =
+      static_cast<int64_t>(b_point.x - a_point.x) * (c_point.y - a_point.y) -
+      static_cast<int64_t>(b_point.y - a_point.y) * (c_point.x - a_point.x);
+  if (double_area == 0) {
+    return;
+  }
+  // counterclockwise, so the inside is on the left of every edge
+  if (double_area < 0) {
+    std::swap(b_point, c_point);
+  }
+
+  struct Edge {
+    Coord origin;
+    int64_t delta_x;
+    int64_t delta_y;
+    // the least edge function value inside
+    int64_t bias;
+  };
+  auto make_edge = [](const Coord& from, const Coord& to) {
+    int64_t delta_x = to.x - from.x;
+    int64_t delta_y = to.y - from.y;
+    bool top_left = delta_y < 0 || (delta_y == 0 && delta_x < 0);
+    return Edge{from, delta_x, delta_y, top_left ? 0 : 1};
+  };
+  Edge edges[] = {make_edge(a_point, b_point), make_edge(b_point, c_point),
+                  make_edge(c_point, a_point)};
+
+  int y_begin = std::min({a_point.y, b_point.y, c_point.y});
+  int y_end = std::max({a_point.y, b_point.y, c_point.y}) + 1;
+  int64_t bound_begin = std::min({a_point.x, b_point.x, c_point.x});
+  int64_t bound_end = std::max({a_point.x, b_point.x, c_point.x}) + 1;
+  for (int y = y_begin; y < y_end; ++y) {
+    int64_t x_begin = bound_begin;
+    int64_t x_end = bound_end;
+    // the edge function delta_x * (y - y0) - delta_y * (x - x0) is linear in x
+    for (const auto& edge : edges) {
+      ClipHalfLine(-edge.delta_y,
+                   edge.bias - edge.delta_x * (y - edge.origin.y) -
+                       edge.delta_y * edge.origin.x,
+                   x_begin, x_end);
+    }
+    if (x_begin < x_end) {
+      visitor(y, static_cast<int>(x_begin), static_cast<int>(x_end));
+    }
+  }
+}
+
+// coverage of a pixel by an anti-aliased primitive
+const int kFullCoverage = 255;
+
+// Steps of a Wu line along its major axis, the coordinates swapped when it
+// is y_major: step(major, pixel, frac) for every major coordinate, the line
+// straddling pixels pixel and pixel + 1 of the minor axis and frac being the
+// coverage of the latter. The minor coordinate is kept in 16.16 fixed point
+// with an exact remainder.
+template <typename Step>
+void ForEachWuStep(const Segment& segment, bool y_major, Step&& step) {
+  Coord a_point = segment.GetA();
+  Coord b_point = segment.GetB();
+  if (y_major) {
+    std::swap(a_point.x, a_point.y);
+    std::swap(b_point.x, b_point.y);
+  }
+  if (b_point.x < a_point.x) {
+    std::swap(a_point, b_point);
+  }
+
+  const int kFracBits = 16;
+  int64_t major_len = b_point.x - a_point.x;
+  if (major_len == 0) {
+    step(a_point.x, a_point.y, 0);
+    return;
+  }
+  int64_t minor_step = static_cast<int64_t>(b_point.y - a_point.y)
+                       << kFracBits;
+  int64_t step_quot = FloorDiv(minor_step, major_len);
+  int64_t step_rem = minor_step - step_quot * major_len;
+
+  int64_t minor = static_cast<int64_t>(a_point.y) << kFracBits;
+  int64_t rem = 0;
+  for (int major = a_point.x; major <= b_point.x; ++major) {
+    step(major, static_cast<int>(minor >> kFracBits),
+         static_cast<int>((minor >> (kFracBits - 8)) & kFullCoverage));
+
+    minor += step_quot;
+    rem += step_rem;
+    if (rem >= major_len) {
+      rem -= major_len;
+      ++minor;
+    }
+  }
+}
+
+inline bool IsYMajor(const Segment& segment) {
+  return std::abs(segment.GetB().y - segment.GetA().y) >
+         std::abs(segment.GetB().x - segment.GetA().x);
+}
+
+// Wu line: visitor(point, coverage) gets the two pixels straddling the line
+// at every step along the major axis, their coverages adding up to full.
+template <typename Visitor>
+void ForEachCoverage(const Segment& segment, Visitor&& visitor) {
+  bool y_major = IsYMajor(segment);
+  auto visit = [&visitor, y_major](int major, int minor, int coverage) {
+    if (coverage != 0) {
+      visitor(y_major ? Coord{minor, major} : Coord{major, minor},
+              static_cast<uint8_t>(coverage));
+    }
+  };
+  ForEachWuStep(segment, y_major, [&visit](int major, int pixel, int frac) {
+    visit(major, pixel, kFullCoverage - frac);
+    visit(major, pixel + 1, frac);
+  });
+}
+
+// longest run of WuRowRuns
+const int kWuRunLength = 64;
+
+// Rows of the pixels of Wu steps along x: Step(x, pixel, frac) puts
+// kFullCoverage - frac in row pixel and frac in row pixel + 1, x going up.
+// The run of a row is done once the steps leave it, long ones are split;
+// visitor(y, x_begin, x_end, coverage), pixels of no coverage included.
+template <typename Visitor>
+class WuRowRuns {
+ public:
+  explicit WuRowRuns(Visitor& visitor) : visitor_(visitor) {}
+  ~WuRowRuns() {
+    Flush(runs_[lower_]);
+    Flush(runs_[lower_ ^ 1]);
+  }
+
+  WuRowRuns(const WuRowRuns&) = delete;
+  WuRowRuns& operator=(const WuRowRuns&) = delete;
+
+  void Step(int x, int pixel, int frac) {
+    auto& lower = runs_[lower_];
+    auto& upper = runs_[lower_ ^ 1];
+    if (started_ && pixel == lower.y + 1) {
+      Flush(lower);
+      lower.y = pixel + 1;
+      lower_ ^= 1;
+    } else if (started_ && pixel == lower.y - 1) {
+      Flush(upper);
+      upper.y = pixel;
+      lower_ ^= 1;
+    } else if (!started_ || pixel != lower.y) {
+      Flush(lower);
+      Flush(upper);
+      lower.y = pixel;
+      upper.y = pixel + 1;
+      started_ = true;
+    }
+    Add(runs_[lower_], x, kFullCoverage - frac);
+    Add(runs_[lower_ ^ 1], x, frac);
+  }
+
+ private:
+  struct Run {
+    int y = 0;
+    int x_begin = 0;
+    int size = 0;
+    uint8_t coverage[kWuRunLength];
+  };
+
+  Visitor& visitor_;
+  Run runs_[2];
+  // the run of row pixel
+  int lower_ = 0;
+  bool started_ = false;
+
+  void Add(Run& run, int x, int value) {
+    if (run.size == kWuRunLength) {
+      Flush(run);
+    }
+    if (run.size == 0) {
+      run.x_begin = x;
+    }
+    run.coverage[run.size++] = static_cast<uint8_t>(value);
+  }
+  void Flush(Run& run) {
+    if (run.size != 0) {
+      visitor_(run.y, run.x_begin, run.x_begin + run.size,
+               static_cast<const uint8_t*>(run.coverage));
+      run.size = 0;
+    }
+  }
+};
+
+// the pixels of ForEachCoverage by rows, see WuRowRuns
+template <typename Visitor>
+void ForEachCoverageRun(const Segment& segment, Visitor&& visitor) {
+  if (IsYMajor(segment)) {
+    ForEachWuStep(segment, true, [&visitor](int y, int pixel, int frac) {
+      const uint8_t coverage[] = {static_cast<uint8_t>(kFullCoverage - frac),
+                                  static_cast<uint8_t>(frac)};
+      visitor(y, pixel, pixel + 2, static_cast<const uint8_t*>(coverage));
+    });
+    return;
+  }
+  WuRowRuns runs(visitor);
+  ForEachWuStep(segment, false, [&runs](int x, int pixel, int frac) {
+    runs.Step(x, pixel, frac);
+  });
+}
+
+// Wu circle: visitor(point, coverage) gets the two pixels straddling the
+// circle in every column of the first octant, mirrored to the others
+template <typename Visitor>
+void ForEachCoverage(const Circe& circle, Visitor&& visitor) {
+  const Coord& center = circle.GetCenter();
+  int64_t radius = circle.GetRadius();
+  if (radius <= 0) {
+    visitor(center, static_cast<uint8_t>(kFullCoverage));
+    return;
+  }
+
+  // the columns past the diagonal are the rows of the mirrored octant
+  auto visit = [&center, &visitor](int x, int y, int coverage) {
+    if (coverage == 0 || x > y) {
+      return;
+    }
+    auto value = static_cast<uint8_t>(coverage);
+    visitor(Coord{center.x + x, center.y + y}, value);
+    visitor(Coord{center.x + x, center.y - y}, value);
+    if (x != 0) {
+      visitor(Coord{center.x - x, center.y + y}, value);
+      visitor(Coord{center.x - x, center.y - y}, value);
+    }
+    if (x == y) {
+      return;
+    }
+    visitor(Coord{center.x + y, center.y + x}, value);
+    visitor(Coord{center.x - y, center.y + x}, value);
+    if (x != 0) {
+      visitor(Coord{center.x + y, center.y - x}, value);
+      visitor(Coord{center.x - y, center.y - x}, value);
+    }
+  };
+
+  for (int x = 0; 2 * static_cast<int64_t>(x) * x <= radius * radius; ++x) {
+    double height = std::sqrt(static_cast<double>(radius * radius -
+                                                  static_cast<int64_t>(x) * x));
+    auto pixel = static_cast<int>(height);
+    auto frac = static_cast<int>((height - pixel) * kFullCoverage + 0.5);
+    visit(x, pixel, kFullCoverage - frac);
+    visit(x, pixel + 1, frac);
+  }
+}
+
+// the pixels of ForEachCoverage of a circle by rows: the columns of the first
+// octant go through WuRowRuns and are mirrored around both axes, the rows of
+// the steep octants have two pixels each
+template <typename Visitor>
+void ForEachCoverageRun(const Circe& circle, Visitor&& visitor) {
+  const Coord& center = circle.GetCenter();
+  int64_t radius = circle.GetRadius();
+  if (radius <= 0) {
+    const uint8_t full = kFullCoverage;
+    visitor(center.y, center.x, center.x + 1, &full);
+    return;
+  }
+
+  // the column x = 0 is on the vertical axis, it is not mirrored
+  auto mirror = [&center, &visitor](int y, int x_begin, int x_end,
+                                    const uint8_t* coverage) {
+    visitor(center.y + y, center.x + x_begin, center.x + x_end, coverage);
+    visitor(center.y - y, center.x + x_begin, center.x + x_end, coverage);
+    int skip = x_begin == 0 ? 1 : 0;
+    uint8_t reversed[kWuRunLength];
+    std::reverse_copy(coverage + skip, coverage + (x_end - x_begin), reversed);
+    if (x_end - x_begin > skip) {
+      const uint8_t* mirrored = reversed;
+      visitor(center.y + y, center.x - x_end + 1, center.x - x_begin - skip + 1,
+              mirrored);
+      visitor(center.y - y, center.x - x_end + 1, center.x - x_begin - skip + 1,
+              mirrored);
+    }
+  };
+
+  WuRowRuns runs(mirror);
+  for (int x = 0; 2 * static_cast<int64_t>(x) * x <= radius * radius; ++x) {
+    double height = std::sqrt(static_cast<double>(radius * radius -
+                                                  static_cast<int64_t>(x) * x));
+    auto pixel = static_cast<int>(height);
+    auto frac = static_cast<int>((height - pixel) * kFullCoverage + 0.5);
+    runs.Step(x, pixel, frac);
+
+    // pixel is on the diagonal when it equals x, the flat octants have it
+    int skip = x == pixel ? 1 : 0;
+    const uint8_t right[] = {static_cast<uint8_t>(kFullCoverage - frac),
+                             static_cast<uint8_t>(frac)};
+    const uint8_t left[] = {right[1], right[0]};
+    for (int y : {center.y + x, center.y - x}) {
+      visitor(y, center.x + pixel + skip, center.x + pixel + 2,
+              static_cast<const uint8_t*>(right + skip));
+      visitor(y, center.x - pixel - 1, center.x - pixel + 1 - skip,
+              static_cast<const uint8_t*>(left));
+      if (x == 0) {
+        break;
+      }
+    }
+  }
+}
+
+// Anti-aliased thick segment: coverage falls from full to none as the
+// distance of the pixel center from the segment goes from radius to
+// radius + 1, so the edge is where the one of ForEachSpan is.
+// visitor(y, x_begin, x_end, coverage) gets every row with the coverage of
+// its pixels, rows go up.
+template <typename Visitor>
+void ForEachCoverageSpan(const Segment& segment, int radius,
+                         Visitor&& visitor) {
+  const Coord& a_point = segment.GetA();
+  double thickness = std::max(radius, 0);
+  double delta_x = segment.GetB().x - a_point.x;
+  double delta_y = segment.GetB().y - a_point.y;
+  double sqr_len = delta_x * delta_x + delta_y * delta_y;
+
+  std::vector<uint8_t> coverage;
+  ForEachSpan(segment, radius + 1, [&](int y, int x_begin, int x_end) {
+    coverage.resize(x_end - x_begin);
+    double rel_y = y - a_point.y;
+    for (int x = x_begin; x < x_end; ++x) {
+      double rel_x = x - a_point.x;
+      double proj = sqr_len == 0 ? 0
+                                 : std::clamp((rel_x * delta_x +
+                                               rel_y * delta_y) / sqr_len,
+                                              0.0, 1.0);
+      double dist_x = rel_x - proj * delta_x;
+      double dist_y = rel_y - proj * delta_y;
+      double sqr_dist = dist_x * dist_x + dist_y * dist_y;
+
+      int value = kFullCoverage;
+      if (sqr_dist > thickness * thickness) {
+        double part = std::max(thickness + 1 - std::sqrt(sqr_dist), 0.0);
+        value = static_cast<int>(part * kFullCoverage + 0.5);
+      }
+      coverage[x - x_begin] = static_cast<uint8_t>(value);
+    }
+    visitor(y, x_begin, x_end, static_cast<const uint8_t*>(coverage.data()));
+  });
+}
+
+// anti-aliased filled disc, see ForEachCoverageSpan of a segment
+template <typename Visitor>
+void ForEachCoverageSpan(const Circe& circle, Visitor&& visitor) {
+  ForEachCoverageSpan(Segment(circle.GetCenter(), circle.GetCenter()),
+                      circle.GetRadius(), visitor);
+}
+
+// lazy view of the pixels of a segment, in ForEachPixel order
+class SegmentPixels : public std::ranges::view_interface<SegmentPixels> {
+ public:
+  class Iterator {
+   public:
+    using value_type = Coord;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+    explicit Iterator(const LineStepper& stepper) : stepper_(stepper) {}
+
+    const Coord& operator*() const { return stepper_.Point(); }
+    Iterator& operator++() {
+      stepper_.Next();
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto prev = *this;
+      stepper_.Next();
+      return prev;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return stepper_.Left() == other.stepper_.Left();
+    }
+    bool operator==(std::default_sentinel_t) const { return stepper_.Done(); }
+
+   private:
+    LineStepper stepper_;
+  };
+
+  SegmentPixels() = default;
+  explicit SegmentPixels(const Segment& segment)
+      : stepper_(segment.GetA(), segment.GetB()) {}
+
+  Iterator begin() const { return Iterator(stepper_); }
+  std::default_sentinel_t end() const { return {}; }
+  size_t size() const { return static_cast<size_t>(stepper_.Left()); }
+
+ private:
+  LineStepper stepper_;
+};
+
+}  // namespace PTIT
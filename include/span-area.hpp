@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <vector>
+
+#include "coord.hpp"
+
+namespace PTIT {
+
+// pixels [x_begin, x_end) of row y
+struct Span {
+  int y;
+  int x_begin;
+  int x_end;
+};
+
+bool operator==(const Span& first, const Span& second) noexcept;
+
+// Set of pixels kept as row spans. Spans are sorted by row, then by x, and
+// never overlap or touch each other. Pixels are iterated row by row.
+class SpanArea {
+ public:
+  class Iterator {
+   public:
+    using value_type = Coord;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+    Iterator(const Span* span, const Span* spans_end)
+        : span_(span),
+          spans_end_(spans_end),
+          x_(span != spans_end ? span->x_begin : 0) {}
+
+    Coord operator*() const { return {x_, span_->y}; }
+    Iterator& operator++() {
+      if (++x_ == span_->x_end) {
+        ++span_;
+        x_ = span_ != spans_end_ ? span_->x_begin : 0;
+      }
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+    bool operator==(const Iterator& other) const {
+      return span_ == other.span_ && x_ == other.x_;
+    }
+
+   private:
+    const Span* span_ = nullptr;
+    const Span* spans_end_ = nullptr;
+    int x_ = 0;
+  };
+
+  SpanArea() = default;
+  // spans may come in any order and overlap
+  explicit SpanArea(std::vector<Span> spans);
+
+  const std::vector<Span>& GetSpans() const { return spans_; }
+  bool IsEmpty() const { return spans_.empty(); }
+  // number of pixels
+  size_t Size() const;
+  bool Contains(const Coord& point) const;
+
+  // closes the gaps between spans of every row
+  void Fill();
+  // moves every pixel by offset
+  void Translate(const Coord& offset);
+
+  SpanArea Unite(const SpanArea& other) const;
+  SpanArea Intersect(const SpanArea& other) const;
+
+  std::list<Coord> GetPoints() const;
+
+  Iterator begin() const {
+    return {spans_.data(), spans_.data() + spans_.size()};
+  }
+  Iterator end() const {
+    return {spans_.data() + spans_.size(), spans_.data() + spans_.size()};
+  }
+
+ private:
+  std::vector<Span> spans_;
+};
+
+}  // namespace PTIT
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "coord.hpp"
+#include "span-area.hpp"
+
+namespace PTIT {
+
+// Circle of a radius rasterized around (0, 0): the outline pixels in the order
+// ForEachPixel visits them and the filled disc
+struct Stencil {
+  int radius;
+  std::vector<Coord> outline;
+  SpanArea disc;
+
+  explicit Stencil(int radius);
+
+  size_t Bytes() const;
+};
+
+// Stencils by radius, shared by the threads. Radii below 0 are the one of 0.
+// Once the stencils take more than max_bytes, some are dropped, the least
+// recently used first as a CLOCK approximates it: a stencil got since the
+// hand last passed it is spared once. A dropped stencil lives on while it is
+// held, but no longer counts towards max_bytes.
+class StencilCache {
+ public:
+  static const size_t kDefaultMaxBytes = size_t(4) << 20;
+
+  explicit StencilCache(size_t max_bytes = kDefaultMaxBytes);
+
+  StencilCache(const StencilCache&) = delete;
+  StencilCache& operator=(const StencilCache&) = delete;
+
+  std::shared_ptr<const Stencil> Get(int radius);
+
+  size_t Hits() const { return hits_; }
+  size_t Misses() const { return misses_; }
+  size_t Size() const;
+  size_t Bytes() const;
+  void Clear();
+
+ private:
+  struct Entry {
+    std::shared_ptr<const Stencil> stencil;
+    // set by hits, under the shared lock, and cleared by the hand
+    std::atomic<bool> referenced = false;
+  };
+
+  size_t max_bytes_;
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<int, Entry> stencils_;
+  // radii in the order the hand visits them
+  std::deque<int> clock_;
+  size_t bytes_ = 0;
+  std::atomic<size_t> hits_ = 0;
+  std::atomic<size_t> misses_ = 0;
+};
+
+// the one Circe::GetGraphic and Circe::GetArea use
+StencilCache& GetStencilCache();
+
+// outline pixels of the stencil around center
+template <typename Visitor>
+void ForEachPixel(const Stencil& stencil, const Coord& center,
+                  Visitor&& visitor) {
+  for (const auto& offset : stencil.outline) {
+    visitor(Coord{center.x + offset.x, center.y + offset.y});
+  }
+}
+
+// disc rows of the stencil around center, visitor(y, x_begin, x_end), rows go
+// up
+template <typename Visitor>
+void ForEachSpan(const Stencil& stencil, const Coord& center,
+                 Visitor&& visitor) {
+  for (const auto& span : stencil.disc.GetSpans()) {
+    visitor(center.y + span.y, center.x + span.x_begin,
+            center.x + span.x_end);
+  }
+}
+
+}  // namespace PTIT
@@ -0,0 +1,318 @@
+#include "binarize.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "image-reader.hpp"
+#include "thread-pool.hpp"
+
+namespace PTIT {
+
+const int kBandRows = 64;
+
+// buffers of a thread
+struct BinarizeScratch {
+  std::vector<uint8_t> gray;
+  std::vector<int16_t> thresholds;
+  // counts of interleaved pixels, so that runs of a level do not wait on
+  // the same counter
+  Histogram counts[4] = {};
+};
+
+// the row itself for gray pixels
+const uint8_t* GrayRow(const PixelView& view, int y, uint8_t* buffer) {
+  const auto* row = view.Row(y);
+  if (view.channels == 1) {
+    return row;
+  }
+  for (int x = 0; x < view.size_x; ++x, row += view.channels) {
+    buffer[x] = static_cast<uint8_t>(
+        (77 * row[0] + 150 * row[1] + 29 * row[2] + 128) >> 8);
+  }
+  return buffer;
+}
+
+Bitmap::Word LowBits(int count) {
+  return count == Bitmap::kWordBits ? ~Bitmap::Word(0)
+                                    : (Bitmap::Word(1) << count) - 1;
+}
+
+// sets the pixels at most threshold bright, the brighter ones when inverted
+void ThresholdRow(const uint8_t* gray, int size_x, int threshold, bool invert,
+                  Bitmap::Word* row) {
+  if (threshold < 0 || threshold >= 255) {
+    bool dark = threshold >= 255;
+    for (int x = 0; x < size_x; x += Bitmap::kWordBits) {
+      row[x / Bitmap::kWordBits] =
+          dark != invert ? LowBits(std::min(size_x - x, Bitmap::kWordBits))
+                         : 0;
+    }
+    return;
+  }
+
+  int x = 0;
+#ifdef __SSE2__
+  __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+  for (; x + Bitmap::kWordBits <= size_x; x += Bitmap::kWordBits) {
+    Bitmap::Word word = 0;
+    for (int part = 0; part < 4; ++part) {
+      __m128i pixels = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(gray + x + 16 * part));
+      __m128i dark = _mm_cmpeq_epi8(_mm_min_epu8(pixels, limit), pixels);
+      word |= Bitmap::Word(static_cast<uint16_t>(_mm_movemask_epi8(dark)))
+              << (16 * part);
+    }
+    row[x / Bitmap::kWordBits] = invert ? ~word : word;
+  }
+#endif
+  for (; x < size_x; x += Bitmap::kWordBits) {
+    int count = std::min(size_x - x, Bitmap::kWordBits);
+    Bitmap::Word word = 0;
+    for (int bit = 0; bit < count; ++bit) {
+      word |= Bitmap::Word(gray[x + bit] <= threshold) << bit;
+    }
+    row[x / Bitmap::kWordBits] = invert ? ~word & LowBits(count) : word;
+  }
+}
+
+// the same with a threshold for every pixel
+void ThresholdRow(const uint8_t* gray, int size_x, const int16_t* thresholds,
+                  bool invert, Bitmap::Word* row) {
+  int x = 0;
+#ifdef __SSE2__
+  __m128i zero = _mm_setzero_si128();
+  for (; x + Bitmap::kWordBits <= size_x; x += Bitmap::kWordBits) {
+    Bitmap::Word word = 0;
+    for (int part = 0; part < 4; ++part) {
+      int offset = x + 16 * part;
+      __m128i pixels =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(gray + offset));
+      __m128i low_limits = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(thresholds + offset));
+      __m128i high_limits = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(thresholds + offset + 8));
+      __m128i light = _mm_packs_epi16(
+          _mm_cmpgt_epi16(_mm_unpacklo_epi8(pixels, zero), low_limits),
+          _mm_cmpgt_epi16(_mm_unpackhi_epi8(pixels, zero), high_limits));
+      word |= Bitmap::Word(static_cast<uint16_t>(_mm_movemask_epi8(light)))
+              << (16 * part);
+    }
+    row[x / Bitmap::kWordBits] = invert ? word : ~word;
+  }
+#endif
+  for (; x < size_x; x += Bitmap::kWordBits) {
+    int count = std::min(size_x - x, Bitmap::kWordBits);
+    Bitmap::Word word = 0;
+    for (int bit = 0; bit < count; ++bit) {
+      word |= Bitmap::Word(gray[x + bit] <= thresholds[x + bit]) << bit;
+    }
+    row[x / Bitmap::kWordBits] = invert ? ~word & LowBits(count) : word;
+  }
+}
+
+void CountRow(const uint8_t* gray, int size_x, Histogram* counts) {
+  int x = 0;
+  for (; x + 4 <= size_x; x += 4) {
+    ++counts[0][gray[x]];
+    ++counts[1][gray[x + 1]];
+    ++counts[2][gray[x + 2]];
+    ++counts[3][gray[x + 3]];
+  }
+  for (; x < size_x; ++x) {
+    ++counts[0][gray[x]];
+  }
+}
+
+int OtsuThreshold(const Histogram& histogram) {
+  double total = 0;
+  double sum = 0;
+  for (int level = 0; level < 256; ++level) {
+    total += histogram[level];
+    sum += static_cast<double>(level) * histogram[level];
+  }
+
+  double dark = 0;
+  double dark_sum = 0;
+  double best_variance = -1;
+  int threshold = 0;
+  for (int level = 0; level < 255; ++level) {
+    dark += histogram[level];
+    dark_sum += static_cast<double>(level) * histogram[level];
+    double light = total - dark;
+    if (dark == 0) {
+      continue;
+    }
+    if (light == 0) {
+      break;
+    }
+    double diff = dark_sum / dark - (sum - dark_sum) / light;
+    double variance = dark * light * diff * diff;
+    if (variance > best_variance) {
+      best_variance = variance;
+      threshold = level;
+    }
+  }
+  return threshold;
+}
+
+// tile means, interpolated between the tile centers into a threshold per
+// pixel
+void AdaptiveThreshold(const PixelView& view, const BinarizeParams& params,
+                       ThreadPool& thread_pool,
+                       std::vector<BinarizeScratch>& scratch, Bitmap& bitmap) {
+  int tile_size = std::max(params.tile_size, 1);
+  int tiles_x = (view.size_x + tile_size - 1) / tile_size;
+  int tiles_y = (view.size_y + tile_size - 1) / tile_size;
+
+  // the last mean of a tile row is repeated, so that interpolation never
+  // needs a bounds check
+  std::vector<float> means(static_cast<size_t>(tiles_x + 1) * tiles_y);
+  thread_pool.ParallelFor(tiles_y, [&](int tile_y, int worker) {
+    std::vector<uint64_t> sums(tiles_x, 0);
+    int y_begin = tile_y * tile_size;
+    int y_end = std::min(y_begin + tile_size, view.size_y);
+    for (int y = y_begin; y < y_end; ++y) {
+      const auto* gray = GrayRow(view, y, scratch[worker].gray.data());
+      for (int tile_x = 0; tile_x < tiles_x; ++tile_x) {
+        int x_end = std::min((tile_x + 1) * tile_size, view.size_x);
+        uint32_t sum = 0;
+        for (int x = tile_x * tile_size; x < x_end; ++x) {
+          sum += gray[x];
+        }
+        sums[tile_x] += sum;
+      }
+    }
+    auto* tile_means =
+        means.data() + static_cast<size_t>(tile_y) * (tiles_x + 1);
+    for (int tile_x = 0; tile_x < tiles_x; ++tile_x) {
+      int width = std::min(tile_size, view.size_x - tile_x * tile_size);
+      tile_means[tile_x] =
+          static_cast<float>(sums[tile_x]) / (width * (y_end - y_begin));
+    }
+    tile_means[tiles_x] = tile_means[tiles_x - 1];
+  });
+
+  auto position = [tile_size](int coord, int tiles, int& tile, float& weight) {
+    float center = (coord + 0.5f) / tile_size - 0.5f;
+    center = std::clamp(center, 0.0f, static_cast<float>(tiles - 1));
+    tile = static_cast<int>(center);
+    weight = center - tile;
+  };
+  std::vector<int> columns(view.size_x);
+  std::vector<float> column_weights(view.size_x);
+  for (int x = 0; x < view.size_x; ++x) {
+    position(x, tiles_x, columns[x], column_weights[x]);
+  }
+
+  int bias = params.dark_foreground ? -params.offset - 1 : params.offset;
+  thread_pool.ParallelFor(tiles_y, [&](int tile_y, int worker) {
+    auto& buffers = scratch[worker];
+    std::vector<float> row_means(tiles_x + 1);
+    int y_end = std::min((tile_y + 1) * tile_size, view.size_y);
+    for (int y = tile_y * tile_size; y < y_end; ++y) {
+      int tile;
+      float weight;
+      position(y, tiles_y, tile, weight);
+      const auto* upper =
+          means.data() + static_cast<size_t>(tile) * (tiles_x + 1);
+      const auto* lower =
+          means.data() +
+          static_cast<size_t>(std::min(tile + 1, tiles_y - 1)) * (tiles_x + 1);
+      for (int tile_x = 0; tile_x <= tiles_x; ++tile_x) {
+        row_means[tile_x] =
+            upper[tile_x] + (lower[tile_x] - upper[tile_x]) * weight;
+      }
+      for (int x = 0; x < view.size_x; ++x) {
+        float left = row_means[columns[x]];
+        float mean = left + (row_means[columns[x] + 1] - left) *
+                                column_weights[x];
+        buffers.thresholds[x] =
+            static_cast<int16_t>(static_cast<int>(mean + 0.5f) + bias);
+      }
+
+      const auto* gray = GrayRow(view, y, buffers.gray.data());
+      ThresholdRow(gray, view.size_x, buffers.thresholds.data(),
+                   !params.dark_foreground, bitmap.Row(y));
+    }
+  });
+}
+
+Bitmap Binarize(const PixelView& view, const BinarizeParams& params) {
+  Bitmap bitmap(view.size_x, view.size_y);
+  if (bitmap.Empty()) {
+    return bitmap;
+  }
+  if (view.channels != 1 && view.channels != 3 && view.channels != 4) {
+    throw std::runtime_error("Unsupported pixel format");
+  }
+
+  ThreadPool thread_pool(std::max(params.threads, 1));
+  std::vector<BinarizeScratch> scratch(thread_pool.Size());
+  for (auto& buffers : scratch) {
+    buffers.gray.resize(view.channels == 1 ? 0 : view.size_x);
+    if (params.mode == ThresholdMode::kAdaptiveMean) {
+      buffers.thresholds.resize(view.size_x);
+    }
+  }
+
+  if (params.mode == ThresholdMode::kAdaptiveMean) {
+    AdaptiveThreshold(view, params, thread_pool, scratch, bitmap);
+    return bitmap;
+  }
+
+  int bands = (view.size_y + kBandRows - 1) / kBandRows;
+  auto for_each_row = [&](auto&& visitor) {
+    thread_pool.ParallelFor(bands, [&](int band, int worker) {
+      int y_end = std::min((band + 1) * kBandRows, view.size_y);
+      for (int y = band * kBandRows; y < y_end; ++y) {
+        visitor(y, GrayRow(view, y, scratch[worker].gray.data()),
+                scratch[worker]);
+      }
+    });
+  };
+
+  int threshold = params.threshold;
+  if (params.mode == ThresholdMode::kOtsu) {
+    for_each_row([&view](int, const uint8_t* gray, BinarizeScratch& buffers) {
+      CountRow(gray, view.size_x, buffers.counts);
+    });
+    Histogram histogram = {};
+    for (const auto& buffers : scratch) {
+      for (const auto& counts : buffers.counts) {
+        for (int level = 0; level < 256; ++level) {
+          histogram[level] += counts[level];
+        }
+      }
+    }
+    threshold = OtsuThreshold(histogram);
+  }
+
+  for_each_row([&](int y, const uint8_t* gray, BinarizeScratch&) {
+    ThresholdRow(gray, view.size_x, threshold, !params.dark_foreground,
+                 bitmap.Row(y));
+  });
+  return bitmap;
+}
+
+Bitmap Binarize(const NetpbmImage& image, const BinarizeParams& params) {
+  if (image.Bilevel()) {
+    return image.ToBitmap();
+  }
+  if (image.MaxValue() > 255) {
+    throw std::runtime_error("Unsupported sample size");
+  }
+  if (image.SizeX() == 0 || image.SizeY() == 0) {
+    return Bitmap(image.SizeX(), image.SizeY());
+  }
+  return Binarize(PixelView{image.Row(0), image.SizeX(), image.SizeY(),
+                            -static_cast<ptrdiff_t>(image.RowBytes()),
+                            image.ChannelsNum()},
+                  params);
+}
+
+}  // namespace PTIT
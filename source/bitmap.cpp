@@ -0,0 +1,111 @@
+#include "bitmap.hpp"
+
+#include <algorithm>
+
+namespace PTIT {
+
+Bitmap::Bitmap(int size_x, int size_y) { Reshape(size_x, size_y); }
+
+void Bitmap::SetRange(int y, int x_begin, int x_end) {
+  if (x_begin >= x_end) {
+    return;
+  }
+  Word* row = Row(y);
+  int first_word = x_begin / kWordBits;
+  int last_word = (x_end - 1) / kWordBits;
+  Word first_mask = ~Word(0) << (x_begin % kWordBits);
+  Word last_mask = ~Word(0) >> (kWordBits - 1 - (x_end - 1) % kWordBits);
+
+  if (first_word == last_word) {
+    row[first_word] |= first_mask & last_mask;
+    return;
+  }
+  row[first_word] |= first_mask;
+  std::fill(row + first_word + 1, row + last_word, ~Word(0));
+  row[last_word] |= last_mask;
+}
+
+void Bitmap::ResetRange(int y, int x_begin, int x_end) {
+  if (x_begin >= x_end) {
+    return;
+  }
+  Word* row = Row(y);
+  int first_word = x_begin / kWordBits;
+  int last_word = (x_end - 1) / kWordBits;
+  Word first_mask = ~Word(0) << (x_begin % kWordBits);
+  Word last_mask = ~Word(0) >> (kWordBits - 1 - (x_end - 1) % kWordBits);
+
+  if (first_word == last_word) {
+    row[first_word] &= ~(first_mask & last_mask);
+    return;
+  }
+  row[first_word] &= ~first_mask;
+  std::fill(row + first_word + 1, row + last_word, Word(0));
+  row[last_word] &= ~last_mask;
+}
+
+bool Bitmap::FindNext(int& x, int& y) const {
+  for (; y < size_y_; ++y, x = 0) {
+    if (FindNextInRow(x, y, size_x_)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Bitmap::FindNextInRow(int& x, int y, int x_end) const {
+  if (x >= x_end) {
+    return false;
+  }
+  const Word* row = Row(y);
+  int word_ind = x / kWordBits;
+  int last_word_ind = (x_end - 1) / kWordBits;
+
+  Word word = row[word_ind] & (~Word(0) << (x % kWordBits));
+  while (word == 0 && word_ind < last_word_ind) {
+    word = row[++word_ind];
+  }
+  if (word == 0) {
+    return false;
+  }
+  x = word_ind * kWordBits + std::countr_zero(word);
+  return x < x_end;
+}
+
+int Bitmap::FindRunEnd(int x, int y) const {
+  if (x >= size_x_) {
+    return size_x_;
+  }
+  const Word* row = Row(y);
+  int word_ind = x / kWordBits;
+  int last_word_ind = (size_x_ - 1) / kWordBits;
+
+  Word gaps = ~row[word_ind] & (~Word(0) << (x % kWordBits));
+  while (gaps == 0 && word_ind < last_word_ind) {
+    gaps = ~row[++word_ind];
+  }
+  if (gaps == 0) {
+    return size_x_;
+  }
+  return std::min(word_ind * kWordBits + std::countr_zero(gaps), size_x_);
+}
+
+size_t Bitmap::Count() const {
+  size_t count = 0;
+  for (auto word : words_) {
+    count += std::popcount(word);
+  }
+  return count;
+}
+
+void Bitmap::Clear() { std::fill(words_.begin(), words_.end(), 0); }
+
+void Bitmap::Reshape(int size_x, int size_y) {
+  size_x_ = size_x;
+  size_y_ = size_y;
+  stride_ = (((size_x + kWordBits - 1) / kWordBits) + kStrideAlignment - 1) /
+            kStrideAlignment * kStrideAlignment;
+  words_.assign(static_cast<size_t>(stride_) * size_y, 0);
+}
+
+}  // namespace PTIT
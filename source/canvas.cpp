@@ -0,0 +1,316 @@
+#include "canvas.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+#include "raster.hpp"
+
+namespace PTIT {
+
+const int kRowAlignment = 64;
+
+// value / 255 rounded, exact for value <= 255 * 255
+int DivMaxColor(int value) {
+  value += 128;
+  return (value + (value >> 8)) >> 8;
+}
+
+#ifdef __SSE2__
+// the same in every 16-bit lane
+__m128i DivMaxColor(__m128i values) {
+  values = _mm_add_epi16(values, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(values, _mm_srli_epi16(values, 8)), 8);
+}
+
+// 8 channels blended source over, every one with its own alpha; the alpha
+// channel is the one of source 255, alpha + dest * (255 - alpha) / 255
+__m128i BlendLanes(__m128i dest, __m128i source, __m128i alpha) {
+  __m128i rest = _mm_sub_epi16(_mm_set1_epi16(RGBA::kMaxColor), alpha);
+  return DivMaxColor(_mm_add_epi16(_mm_mullo_epi16(source, alpha),
+                                   _mm_mullo_epi16(dest, rest)));
+}
+
+// blends 8 pixels at a time, returns the number blended
+template <int kChannels>
+int BlendPixels(uint8_t* dest, const uint8_t* coverage, int count,
+                const RGBA& color) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i color_alpha = _mm_set1_epi16(color.alpha);
+  short red = color.red;
+  short green = color.green;
+  short blue = color.blue;
+  short opaque = RGBA::kMaxColor;
+
+  int index = 0;
+  for (; index + 8 <= count; index += 8, dest += 8 * kChannels) {
+    __m128i alpha = DivMaxColor(_mm_mullo_epi16(
+        _mm_unpacklo_epi8(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(coverage + index)),
+            zero),
+        color_alpha));
+
+    if constexpr (kChannels == 4) {
+      // two pixels in a vector of channels
+      __m128i source = _mm_setr_epi16(red, green, blue, opaque, red, green,
+                                      blue, opaque);
+      __m128i pairs[] = {_mm_unpacklo_epi16(alpha, alpha),
+                         _mm_unpackhi_epi16(alpha, alpha)};
+      for (int half = 0; half < 2; ++half) {
+        auto* bytes = reinterpret_cast<__m128i*>(dest + 16 * half);
+        __m128i pixels = _mm_loadu_si128(bytes);
+        __m128i low = BlendLanes(_mm_unpacklo_epi8(pixels, zero), source,
+                                 _mm_unpacklo_epi32(pairs[half], pairs[half]));
+        __m128i high = BlendLanes(_mm_unpackhi_epi8(pixels, zero), source,
+                                  _mm_unpackhi_epi32(pairs[half], pairs[half]));
+        _mm_storeu_si128(bytes, _mm_packus_epi16(low, high));
+      }
+    } else {
+      // the 24 channels are three vectors, a pixel may straddle two
+      __m128i sources[] = {
+          _mm_setr_epi16(red, green, blue, red, green, blue, red, green),
+          _mm_setr_epi16(blue, red, green, blue, red, green, blue, red),
+          _mm_setr_epi16(green, blue, red, green, blue, red, green, blue)};
+      __m128i low_alpha = _mm_unpacklo_epi64(alpha, alpha);
+      __m128i high_alpha = _mm_unpackhi_epi64(alpha, alpha);
+      __m128i alphas[] = {
+          _mm_shufflehi_epi16(
+              _mm_shufflelo_epi16(low_alpha, _MM_SHUFFLE(1, 0, 0, 0)),
+              _MM_SHUFFLE(2, 2, 1, 1)),
+          _mm_shufflehi_epi16(
+              _mm_shufflelo_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 2)),
+              _MM_SHUFFLE(1, 0, 0, 0)),
+          _mm_shufflehi_epi16(
+              _mm_shufflelo_epi16(high_alpha, _MM_SHUFFLE(2, 2, 1, 1)),
+              _MM_SHUFFLE(3, 3, 3, 2))};
+
+      auto* first = reinterpret_cast<__m128i*>(dest);
+      auto* second = reinterpret_cast<__m128i*>(dest + 16);
+      __m128i pixels = _mm_loadu_si128(first);
+      __m128i rest = _mm_loadl_epi64(second);
+      __m128i blended[] = {
+          BlendLanes(_mm_unpacklo_epi8(pixels, zero), sources[0], alphas[0]),
+          BlendLanes(_mm_unpackhi_epi8(pixels, zero), sources[1], alphas[1]),
+          BlendLanes(_mm_unpacklo_epi8(rest, zero), sources[2], alphas[2])};
+      _mm_storeu_si128(first, _mm_packus_epi16(blended[0], blended[1]));
+      _mm_storel_epi64(second, _mm_packus_epi16(blended[2], blended[2]));
+    }
+  }
+  return index;
+}
+#endif
+
+template <int kChannels>
+void BlendRow(uint8_t* dest, const uint8_t* coverage, int count,
+              const RGBA& color) {
+  int i = 0;
+#ifdef __SSE2__
+  i = BlendPixels<kChannels>(dest, coverage, count, color);
+  dest += i * kChannels;
+#endif
+  const int source[] = {color.red, color.green, color.blue};
+  for (; i < count; ++i, dest += kChannels) {
+    int alpha = DivMaxColor(coverage[i] * color.alpha);
+    for (int channel = 0; channel < 3; ++channel) {
+      dest[channel] = static_cast<uint8_t>(
+          DivMaxColor(source[channel] * alpha +
+                      dest[channel] * (RGBA::kMaxColor - alpha)));
+    }
+    if constexpr (kChannels == 4) {
+      dest[3] = static_cast<uint8_t>(
+          alpha + DivMaxColor(dest[3] * (RGBA::kMaxColor - alpha)));
+    }
+  }
+}
+
+Canvas::Canvas(int size_x, int size_y, bool has_alpha,
+               const RGBA& background)
+    : size_x_(size_x),
+      size_y_(size_y),
+      channels_num_(has_alpha ? 4 : 3),
+      stride_((static_cast<ptrdiff_t>(size_x) * channels_num_ +
+               kRowAlignment - 1) /
+              kRowAlignment * kRowAlignment),
+      pixels_(static_cast<size_t>(stride_) * size_y) {
+  Clear(background);
+}
+
+RGBA Canvas::GetPixel(int x, int y) const {
+  const uint8_t* pixel = Row(y) + x * channels_num_;
+  return {pixel[0], pixel[1], pixel[2],
+          static_cast<short>(channels_num_ == 4 ? pixel[3] : RGBA::kMaxColor)};
+}
+
+void Canvas::Plot(const Coord& point, const RGBA& color) {
+  if (Contains(point.x, point.y)) {
+    PutPixel(point.x, point.y, color);
+  }
+}
+
+void Canvas::Clear(const RGBA& color) {
+  if (size_y_ == 0 || size_x_ == 0) {
+    return;
+  }
+  for (int x = 0; x < size_x_; ++x) {
+    PutPixel(x, 0, color);
+  }
+  for (int y = 1; y < size_y_; ++y) {
+    std::copy(Row(0), Row(0) + stride_, Row(y));
+  }
+}
+
+void Canvas::FillSpan(int y, int x_begin, int x_end, const RGBA& color) {
+  if (y < 0 || y >= size_y_) {
+    return;
+  }
+  x_begin = std::max(x_begin, 0);
+  x_end = std::min(x_end, size_x_);
+  if (x_begin >= x_end) {
+    return;
+  }
+
+  uint8_t* begin = Row(y) + x_begin * channels_num_;
+  size_t size = static_cast<size_t>(x_end - x_begin) * channels_num_;
+  if (color.red == color.green && color.green == color.blue &&
+      (channels_num_ == 3 || color.blue == color.alpha)) {
+    std::memset(begin, static_cast<uint8_t>(color.red), size);
+    return;
+  }
+
+  // the filled prefix is doubled until the span is covered
+  PutPixel(x_begin, y, color);
+  for (size_t filled = channels_num_; filled < size;) {
+    size_t count = std::min(filled, size - filled);
+    std::memcpy(begin + filled, begin, count);
+    filled += count;
+  }
+}
+
+void Canvas::Draw(const Segment& segment, const RGBA& color) {
+  ForEachPixel(segment,
+               [this, &color](const Coord& point) { Plot(point, color); });
+}
+
+void Canvas::Draw(const Triangle& triangle, const RGBA& color) {
+  ForEachPixel(triangle,
+               [this, &color](const Coord& point) { Plot(point, color); });
+}
+
+void Canvas::Draw(const Circe& circle, const RGBA& color) {
+  ForEachPixel(circle,
+               [this, &color](const Coord& point) { Plot(point, color); });
+}
+
+void Canvas::Draw(const Primitive& primitive, const RGBA& color) {
+  for (const auto& point : primitive.GetGraphic()) {
+    Plot(point, color);
+  }
+}
+
+void Canvas::Fill(const Circe& circle, const RGBA& color) {
+  ForEachSpan(circle, [this, &color](int y, int x_begin, int x_end) {
+    FillSpan(y, x_begin, x_end, color);
+  });
+}
+
+void Canvas::Fill(const Triangle& triangle, const RGBA& color) {
+  ForEachSpan(triangle, [this, &color](int y, int x_begin, int x_end) {
+    FillSpan(y, x_begin, x_end, color);
+  });
+}
+
+void Canvas::Fill(const Segment& segment, int radius, const RGBA& color) {
+  ForEachSpan(segment, radius, [this, &color](int y, int x_begin, int x_end) {
+    FillSpan(y, x_begin, x_end, color);
+  });
+}
+
+void Canvas::Fill(const SpanArea& area, const RGBA& color) {
+  for (const auto& span : area.GetSpans()) {
+    FillSpan(span.y, span.x_begin, span.x_end, color);
+  }
+}
+
+void Canvas::Blend(const Coord& point, uint8_t coverage, const RGBA& color) {
+  BlendSpan(point.y, point.x, point.x + 1, &coverage, color);
+}
+
+void Canvas::BlendSpan(int y, int x_begin, int x_end, const uint8_t* coverage,
+                       const RGBA& color) {
+  if (y < 0 || y >= size_y_) {
+    return;
+  }
+  if (x_begin < 0) {
+    coverage -= x_begin;
+    x_begin = 0;
+  }
+  x_end = std::min(x_end, size_x_);
+  if (x_begin >= x_end) {
+    return;
+  }
+
+  uint8_t* dest = Row(y) + x_begin * channels_num_;
+  if (channels_num_ == 4) {
+    BlendRow<4>(dest, coverage, x_end - x_begin, color);
+  } else {
+    BlendRow<3>(dest, coverage, x_end - x_begin, color);
+  }
+}
+
+void Canvas::DrawSmooth(const Segment& segment, const RGBA& color) {
+  ForEachCoverageRun(segment, [this, &color](int y, int x_begin, int x_end,
+                                             const uint8_t* coverage) {
+    BlendSpan(y, x_begin, x_end, coverage, color);
+  });
+}
+
+void Canvas::DrawSmooth(const Circe& circle, const RGBA& color) {
+  ForEachCoverageRun(circle, [this, &color](int y, int x_begin, int x_end,
+                                            const uint8_t* coverage) {
+    BlendSpan(y, x_begin, x_end, coverage, color);
+  });
+}
+
+void Canvas::FillSmooth(const Segment& segment, int radius,
+                        const RGBA& color) {
+  ForEachCoverageSpan(segment, radius,
+                      [this, &color](int y, int x_begin, int x_end,
+                                     const uint8_t* coverage) {
+                        BlendSpan(y, x_begin, x_end, coverage, color);
+                      });
+}
+
+void Canvas::FillSmooth(const Circe& circle, const RGBA& color) {
+  ForEachCoverageSpan(circle, [this, &color](int y, int x_begin, int x_end,
+                                             const uint8_t* coverage) {
+    BlendSpan(y, x_begin, x_end, coverage, color);
+  });
+}
+
+void CreateImage(const char* image_file, const Canvas& canvas,
+                 ImageFormat format) {
+  ImageWriter writer(image_file, canvas.SizeX(), canvas.SizeY(), format);
+  bool same_layout = writer.ChannelsNum() == canvas.ChannelsNum() &&
+                     format != ImageFormat::kPGM;
+  std::vector<uint8_t> row(
+      same_layout ? 0 : canvas.SizeX() * writer.ChannelsNum());
+
+  for (int y = canvas.SizeY() - 1; y >= 0; --y) {
+    if (same_layout) {
+      writer.WriteRow(canvas.Row(y));
+      continue;
+    }
+    auto* dest = row.data();
+    for (int x = 0; x < canvas.SizeX(); ++x) {
+      dest = PackPixel(canvas.GetPixel(x, y), format, dest);
+    }
+    writer.WriteRow(row.data());
+  }
+
+  writer.Close();
+}
+
+}  // namespace PTIT
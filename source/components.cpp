@@ -0,0 +1,162 @@
+#include "components.hpp"
+
+#include <stdint.h>
+
+#include <algorithm>
+
+namespace PTIT {
+
+// union-find over run indices, the root of a tree is its least index
+class RunForest {
+ public:
+  RunForest(CountedVector<int32_t>& parents, size_t size) : parents_(parents) {
+    parents_.resize(size);
+    for (size_t index = 0; index < size; ++index) {
+      parents_[index] = static_cast<int32_t>(index);
+    }
+  }
+
+  int32_t Find(int32_t index) {
+    while (parents_[index] != index) {
+      parents_[index] = parents_[parents_[index]];
+      index = parents_[index];
+    }
+    return index;
+  }
+
+  void Unite(int32_t first, int32_t second) {
+    first = Find(first);
+    second = Find(second);
+    if (first != second) {
+      parents_[std::max(first, second)] = std::min(first, second);
+    }
+  }
+
+ private:
+  CountedVector<int32_t>& parents_;
+};
+
+void FindComponents(const Bitmap& bitmap, Components& components) {
+  auto& runs = components.row_runs;
+  auto& row_begins = components.row_begins;
+  runs.clear();
+  row_begins.assign(bitmap.SizeY() + 1, 0);
+  for (int y = 0; y < bitmap.SizeY(); ++y) {
+    row_begins[y] = runs.size();
+    for (int x = 0; bitmap.FindNextInRow(x, y, bitmap.SizeX());) {
+      int x_end = bitmap.FindRunEnd(x, y);
+      runs.push_back({y, x, x_end});
+      x = x_end;
+    }
+  }
+  row_begins[bitmap.SizeY()] = runs.size();
+
+  // first pass: runs of neighbouring rows are 8-connected when they overlap
+  // after widening one of them by a pixel on each side
+  RunForest forest(components.parents, runs.size());
+  for (int y = 1; y < bitmap.SizeY(); ++y) {
+    size_t prev = row_begins[y - 1];
+    size_t prev_end = row_begins[y];
+    for (size_t curr = row_begins[y]; curr < row_begins[y + 1]; ++curr) {
+      while (prev < prev_end && runs[prev].x_end < runs[curr].x_begin) {
+        ++prev;
+      }
+      for (size_t touching = prev;
+           touching < prev_end && runs[touching].x_begin <= runs[curr].x_end;
+           ++touching) {
+        forest.Unite(static_cast<int32_t>(touching),
+                     static_cast<int32_t>(curr));
+      }
+    }
+  }
+
+  // second pass: roots come first in their trees, so components are numbered
+  // in the order of their first runs
+  auto& labels = components.labels;
+  labels.resize(runs.size());
+  components.list.clear();
+  for (size_t index = 0; index < runs.size(); ++index) {
+    auto root = forest.Find(static_cast<int32_t>(index));
+    const auto& run = runs[index];
+    if (root == static_cast<int32_t>(index)) {
+      labels[index] = static_cast<int32_t>(components.list.size());
+      components.list.push_back({{run.x_begin, run.y},
+                                 {run.x_end, run.y + 1},
+                                 0,
+                                 0,
+                                 0});
+    } else {
+      labels[index] = labels[root];
+    }
+
+    auto& component = components.list[labels[index]];
+    component.begin.x = std::min(component.begin.x, run.x_begin);
+    component.end.x = std::max(component.end.x, run.x_end);
+    component.end.y = run.y + 1;
+    component.pixels += run.x_end - run.x_begin;
+    ++component.runs_end;
+  }
+
+  // runs are grouped by component keeping their order
+  size_t offset = 0;
+  for (auto& component : components.list) {
+    component.runs_begin = offset;
+    offset += component.runs_end;
+    component.runs_end = component.runs_begin;
+  }
+  components.runs.resize(runs.size());
+  for (size_t index = 0; index < runs.size(); ++index) {
+    auto& component = components.list[labels[index]];
+    components.runs[component.runs_end++] = runs[index];
+  }
+}
+
+Component TakeComponent(Bitmap& bitmap, const Coord& start,
+                        CountedVector<Run>& runs, size_t max_runs) {
+  auto take_run = [&bitmap, &runs](int x, int y) {
+    int x_begin = x;
+    while (x_begin > 0 && bitmap.Get(x_begin - 1, y)) {
+      --x_begin;
+    }
+    int x_end = bitmap.FindRunEnd(x, y);
+    bitmap.ResetRange(y, x_begin, x_end);
+    runs.push_back({y, x_begin, x_end});
+  };
+
+  Component component = {start, start, 0, runs.size(), 0};
+  take_run(start.x, start.y);
+  // the runs taken are the queue of the ones whose neighbours are looked for
+  for (auto index = component.runs_begin;
+       index < runs.size() && runs.size() <= max_runs; ++index) {
+    auto run = runs[index];
+    for (int y : {run.y - 1, run.y + 1}) {
+      if (y < 0 || y >= bitmap.SizeY()) {
+        continue;
+      }
+      int x_end = std::min(run.x_end + 1, bitmap.SizeX());
+      for (int x = std::max(run.x_begin - 1, 0);
+           bitmap.FindNextInRow(x, y, x_end); x = runs.back().x_end) {
+        take_run(x, y);
+      }
+    }
+  }
+  component.runs_end = runs.size();
+
+  std::sort(runs.begin() + component.runs_begin, runs.end(),
+            [](const Run& first, const Run& second) {
+              return first.y != second.y ? first.y < second.y
+                                         : first.x_begin < second.x_begin;
+            });
+  component.begin = {runs[component.runs_begin].x_begin,
+                     runs[component.runs_begin].y};
+  component.end = {0, runs.back().y + 1};
+  for (auto index = component.runs_begin; index < component.runs_end;
+       ++index) {
+    component.begin.x = std::min(component.begin.x, runs[index].x_begin);
+    component.end.x = std::max(component.end.x, runs[index].x_end);
+    component.pixels += runs[index].x_end - runs[index].x_begin;
+  }
+  return component;
+}
+
+}  // namespace PTIT
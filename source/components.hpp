@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitmap.hpp"
+#include "coord.hpp"
+#include "counting-allocator.hpp"
+
+namespace PTIT {
+
+// pixels [x_begin, x_end) of row y
+struct Run {
+  int y;
+  int x_begin;
+  int x_end;
+};
+
+struct Component {
+  // bounding box, end excluded
+  Coord begin;
+  Coord end;
+  size_t pixels;
+  // the runs of the component in Components::runs
+  size_t runs_begin;
+  size_t runs_end;
+};
+
+// 8-connected components of a bitmap, ordered by their first pixel in
+// row-major order; the runs of every component are row-major too. Its buffers
+// are allocated through the counter and kept from one search to the next.
+struct Components {
+  CountedVector<Run> runs;
+  CountedVector<Component> list;
+
+  // scratch of FindComponents
+  CountedVector<size_t> row_begins;
+  CountedVector<Run> row_runs;
+  CountedVector<int32_t> parents;
+  CountedVector<int32_t> labels;
+
+  explicit Components(AllocationCounter* counter)
+      : runs(CountingAllocator<Run>(counter)),
+        list(CountingAllocator<Component>(counter)),
+        row_begins(CountingAllocator<size_t>(counter)),
+        row_runs(CountingAllocator<Run>(counter)),
+        parents(CountingAllocator<int32_t>(counter)),
+        labels(CountingAllocator<int32_t>(counter)) {}
+};
+
+// Two passes over the row runs: runs touching runs of the previous row are
+// united in a union-find forest, then every tree becomes a component. The
+// components found before are replaced.
+void FindComponents(const Bitmap& bitmap, Components& components);
+
+// The 8-connected component of the set pixel start, found by following its
+// runs row to row, so the cost is the one of the component, not of the
+// bitmap. Its runs are appended to runs in row-major order and reset in the
+// bitmap. Once runs holds more than max_runs, the search stops and the
+// component is only partly taken.
+Component TakeComponent(Bitmap& bitmap, const Coord& start,
+                        CountedVector<Run>& runs,
+                        size_t max_runs = static_cast<size_t>(-1));
+
+}  // namespace PTIT
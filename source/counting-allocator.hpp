@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace PTIT {
+
+// Counts the heap allocations made through it. Single objects freed through
+// it are kept for the next single objects of the same size, so that lists
+// whose nodes come and go stop allocating once they have grown; they are
+// released with the counter, or handed to another counter by Give. A counter
+// is used by one thread at a time, but for the objects it keeps as the pool
+// of others: a counter out of kept objects takes a batch of them from its
+// pool before allocating, and gives one back when it keeps two.
+class AllocationCounter {
+ public:
+  static constexpr size_t kLendBatch = 32;
+
+  size_t allocations = 0;
+  size_t bytes = 0;
+
+  AllocationCounter() = default;
+  ~AllocationCounter() {
+    for (auto& cache : caches_) {
+      while (cache.head != nullptr) {
+        auto* next = cache.head->next;
+        ::operator delete(cache.head);
+        cache.head = next;
+      }
+    }
+  }
+
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+  // the pool has to outlive the counter
+  void SetPool(AllocationCounter* pool) { pool_ = pool; }
+
+  void* Allocate(size_t size, size_t count) {
+    if (count == 1 && size >= sizeof(FreeBlock)) {
+      for (auto& cache : caches_) {
+        if (cache.size == size && cache.head != nullptr) {
+          auto* block = cache.head;
+          cache.head = block->next;
+          --cache.count;
+          return block;
+        }
+      }
+      if (pool_ != nullptr && pool_->Lend(*this, size)) {
+        return Allocate(size, count);
+      }
+    }
+    ++allocations;
+    bytes += size * count;
+    return ::operator new(size * count);
+  }
+
+  // counts an allocation of a buffer that cannot take an allocator
+  void Count(size_t size) {
+    ++allocations;
+    bytes += size;
+  }
+
+  void Deallocate(void* pointer, size_t size, size_t count) {
+    if (count != 1 || size < sizeof(FreeBlock)) {
+      ::operator delete(pointer);
+      return;
+    }
+    auto& cache = FindCache(size);
+    Push(cache, static_cast<FreeBlock*>(pointer));
+    if (pool_ != nullptr && cache.count >= 2 * kLendBatch) {
+      pool_->Take(cache);
+    }
+  }
+
+  // hands every object kept here to the pool, for the objects freed by one
+  // thread to be allocated by others
+  void Give(AllocationCounter& pool) {
+    std::lock_guard lock(pool.mutex_);
+    for (auto& cache : caches_) {
+      auto& pool_cache = pool.FindCache(cache.size);
+      while (cache.head != nullptr) {
+        auto* block = cache.head;
+        cache.head = block->next;
+        Push(pool_cache, block);
+      }
+      cache.count = 0;
+    }
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  struct Cache {
+    size_t size;
+    FreeBlock* head = nullptr;
+    size_t count = 0;
+  };
+
+  // one per object size, there are only a few of them
+  std::vector<Cache> caches_;
+  AllocationCounter* pool_ = nullptr;
+  // locks the caches while the counter lends to others
+  std::mutex mutex_;
+
+  // moves a batch of the objects kept in the cache of another counter here
+  void Take(Cache& other_cache) {
+    std::lock_guard lock(mutex_);
+    auto& cache = FindCache(other_cache.size);
+    for (size_t taken = 0; taken < kLendBatch; ++taken) {
+      auto* block = other_cache.head;
+      other_cache.head = block->next;
+      --other_cache.count;
+      Push(cache, block);
+    }
+  }
+
+  // moves a batch of the objects of the size kept here to other, false when
+  // there are none
+  bool Lend(AllocationCounter& other, size_t size) {
+    std::lock_guard lock(mutex_);
+    auto& cache = FindCache(size);
+    if (cache.head == nullptr) {
+      return false;
+    }
+    auto& other_cache = other.FindCache(size);
+    for (size_t lent = 0; lent < kLendBatch && cache.head != nullptr; ++lent) {
+      auto* block = cache.head;
+      cache.head = block->next;
+      --cache.count;
+      Push(other_cache, block);
+    }
+    return true;
+  }
+
+  Cache& FindCache(size_t size) {
+    for (auto& cache : caches_) {
+      if (cache.size == size) {
+        return cache;
+      }
+    }
+    return caches_.emplace_back(Cache{size});
+  }
+
+  static void Push(Cache& cache, FreeBlock* block) {
+    block->next = cache.head;
+    cache.head = block;
+    ++cache.count;
+  }
+};
+
+// allocator going through a counter, instances are interchangeable whatever
+// counter they use
+template <typename T>
+class CountingAllocator {
+ public:
+  using value_type = T;
+
+  static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+  explicit CountingAllocator(AllocationCounter* counter) : counter_(counter) {}
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>& other)
+      : counter_(other.GetCounter()) {}
+
+  T* allocate(size_t count) {
+    return static_cast<T*>(counter_->Allocate(sizeof(T), count));
+  }
+  void deallocate(T* pointer, size_t count) {
+    counter_->Deallocate(pointer, sizeof(T), count);
+  }
+
+  AllocationCounter* GetCounter() const { return counter_; }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U>&) const {
+    return true;
+  }
+
+ private:
+  AllocationCounter* counter_;
+};
+
+template <typename T>
+using CountedVector = std::vector<T, CountingAllocator<T>>;
+template <typename T>
+using CountedList = std::list<T, CountingAllocator<T>>;
+
+}  // namespace PTIT
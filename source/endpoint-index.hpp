@@ -0,0 +1,141 @@
+#pragma once
+
+#include <limits.h>
+#include <stdint.h>
+
+#include <cstddef>
+
+#include "coord.hpp"
+#include "counting-allocator.hpp"
+
+namespace PTIT {
+
+// Map from segment endpoints to values: open addressing with linear probing,
+// erasing shifts the following entries back instead of leaving tombstones.
+// Memory is proportional to the number of endpoints, not to the image area.
+template <typename Value>
+class EndpointIndex {
+ public:
+  EndpointIndex(size_t expected, AllocationCounter* counter)
+      : slots_(CountingAllocator<Slot>(counter)) {
+    Rehash(expected);
+  }
+
+  size_t Size() const { return size_; }
+
+  // empties the index, sized for the entries expected; only the slots needed
+  // for them are cleared, the storage grown for more is kept
+  void Reset(size_t expected) {
+    auto capacity = Capacity(expected);
+    if (capacity > slots_.capacity()) {
+      slots_.clear();
+      Rehash(expected);
+      return;
+    }
+    slots_.assign(capacity, Slot{kEmptyKey, Value()});
+    mask_ = capacity - 1;
+    size_ = 0;
+  }
+
+  Value* Find(const Coord& point) {
+    for (size_t index = Home(point);; index = (index + 1) & mask_) {
+      auto& slot = slots_[index];
+      if (IsEmpty(slot)) {
+        return nullptr;
+      }
+      if (SameKey(slot.key, point)) {
+        return &slot.value;
+      }
+    }
+  }
+
+  void Set(const Coord& point, const Value& value) {
+    if (auto* found = Find(point)) {
+      *found = value;
+      return;
+    }
+    if (2 * (size_ + 1) > slots_.size()) {
+      Rehash(size_ + 1);
+    }
+    Insert({point, value});
+  }
+
+  void Erase(const Coord& point) {
+    size_t hole = Home(point);
+    for (; !SameKey(slots_[hole].key, point); hole = (hole + 1) & mask_) {
+      if (IsEmpty(slots_[hole])) {
+        return;
+      }
+    }
+
+    // entries after the hole that may not be reached past it are moved into it
+    for (size_t index = (hole + 1) & mask_; !IsEmpty(slots_[index]);
+         index = (index + 1) & mask_) {
+      size_t home = Home(slots_[index].key);
+      if (((index - home) & mask_) >= ((index - hole) & mask_)) {
+        slots_[hole] = slots_[index];
+        hole = index;
+      }
+    }
+    slots_[hole].key = kEmptyKey;
+    --size_;
+  }
+
+ private:
+  struct Slot {
+    Coord key;
+    Value value;
+  };
+
+  static constexpr Coord kEmptyKey = {INT_MIN, INT_MIN};
+
+  CountedVector<Slot> slots_;
+  size_t mask_ = 0;
+  size_t size_ = 0;
+
+  static bool SameKey(const Coord& first, const Coord& second) {
+    return first.x == second.x && first.y == second.y;
+  }
+  static bool IsEmpty(const Slot& slot) { return SameKey(slot.key, kEmptyKey); }
+
+  size_t Home(const Coord& point) const {
+    uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(point.x)) << 32 |
+                   static_cast<uint32_t>(point.y);
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask_;
+  }
+
+  void Insert(const Slot& entry) {
+    size_t index = Home(entry.key);
+    while (!IsEmpty(slots_[index])) {
+      index = (index + 1) & mask_;
+    }
+    slots_[index] = entry;
+    ++size_;
+  }
+
+  // a power of two at least twice the number of entries
+  static size_t Capacity(size_t entries) {
+    size_t capacity = 16;
+    while (capacity < 2 * entries) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  void Rehash(size_t entries) {
+    auto capacity = Capacity(entries);
+
+    CountedVector<Slot> old_slots(capacity, Slot{kEmptyKey, Value()},
+                                  slots_.get_allocator());
+    old_slots.swap(slots_);
+    mask_ = capacity - 1;
+    size_ = 0;
+    for (const auto& slot : old_slots) {
+      if (!IsEmpty(slot)) {
+        Insert(slot);
+      }
+    }
+  }
+};
+
+}  // namespace PTIT
@@ -0,0 +1,37 @@
+#include <ostream>
+
+#include "primitives.hpp"
+
+namespace PTIT {
+
+double ExtractStats::PhaseSeconds(std::string_view phase) const {
+  double micros = 0;
+  for (const auto& event : events) {
+    if (event.phase == phase) {
+      micros += event.duration_us;
+    }
+  }
+  return micros / 1e6;
+}
+
+void ExtractStats::WriteChromeTrace(std::ostream& out) const {
+  out << "{\"traceEvents\": [";
+  for (size_t index = 0; index < events.size(); ++index) {
+    const auto& event = events[index];
+    out << (index == 0 ? "\n" : ",\n") << "  {\"name\": \"" << event.phase
+        << "\", \"cat\": \"extract\", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+        << event.thread << ", \"ts\": " << event.start_us
+        << ", \"dur\": " << event.duration_us << "}";
+  }
+  out << "\n], \"displayTimeUnit\": \"ms\", \"otherData\": {"
+      << "\"allocations\": " << allocations
+      << ", \"allocated_bytes\": " << allocated_bytes
+      << ", \"pixels_visited\": " << pixels_visited
+      << ", \"max_stack_depth\": " << max_stack_depth
+      << ", \"raw_segments\": " << raw_segments
+      << ", \"segments\": " << segments
+      << ", \"merge_attempts\": " << merge_attempts
+      << ", \"merges\": " << merges << "}}\n";
+}
+
+}  // namespace PTIT
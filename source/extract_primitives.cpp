@@ -1,92 +1,37 @@
+#include <stdint.h>
+
 #include <algorithm>
-#include <cmath>
+#include <chrono>
 #include <list>
-#include <optional>
-#include <queue>
-#include <stack>
-
+#include <map>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "components.hpp"
+#include "counting-allocator.hpp"
+#include "endpoint-index.hpp"
+#include "extractor.hpp"
+#include "k-range.hpp"
 #include "primitives.hpp"
 #include "supply.hpp"
+#include "thread-pool.hpp"
 
 namespace PTIT {
 
-const double kDegAccuracy = 0.001;
-using BaseSegment = std::list<Coord>;
-
 enum EDeviation { Negative, Neutral, Positive };
 using Deviation = std::pair<EDeviation, EDeviation>;
 
-std::list<Coord> GetNeighbours(Coord point, int x_size = -1, int y_size = -1) {
-  bool has_borders = x_size != -1;
-
-  std::list<Coord> neighbours;
-
-  for (int x = point.x - 1; x <= point.x + 1; ++x) {
-    for (int y = point.y - 1; y <= point.y + 1; ++y) {
-      if (has_borders && (x < 0 || y < 0 || x >= x_size || y >= y_size)) {
-        continue;
-      }
-      if (x == point.x && y == point.y) {
-        continue;
-      }
-      neighbours.push_back({x, y});
-    }
-  }
-  return neighbours;
-}
-
-class KRange {
- public:
-  KRange(bool empty = false) : is_empty_(empty){};
-  KRange(double min_angle, double max_angle)
-      : min_angle_(min_angle), max_angle_(max_angle) {
-    if (max_angle_ < min_angle_) {
-      std::swap(min_angle_, max_angle_);
-    }
-  }
-
-  KRange(const KRange&) = default;
-  KRange(KRange&&) = default;
-  KRange& operator=(const KRange&) = default;
-  KRange& operator=(KRange&&) = default;
-
-  ~KRange() = default;
-
-  bool InRange(double k_coef) const {
-    if (is_empty_) {
-      return false;
-    }
-    auto deg = TanToDeg(k_coef);
-
-    return AreIntersect(*this, KRange(deg - kDegAccuracy, deg + kDegAccuracy));
-  }
-  void Intersect(const KRange& k_range) {
-    if (is_empty_ || k_range.is_empty_) {
-      is_empty_ = true;
-      return;
-    }
+struct Region {
+  Coord begin;
+  Coord end;
 
-    min_angle_ = std::max(min_angle_, k_range.min_angle_);
-    max_angle_ = std::min(max_angle_, k_range.max_angle_);
-
-    if (min_angle_ > max_angle_) {
-      is_empty_ = true;
-    }
-  }
-
- private:
-  bool is_empty_ = false;
-  double min_angle_ = -kDegInCircle / 4;
-  double max_angle_ = kDegInCircle / 4;
-
-  static bool AreIntersect(KRange first, KRange second) {
-    if (first.min_angle_ == second.min_angle_) {
-      return true;
-    }
-    if (first.min_angle_ > second.min_angle_) {
-      std::swap(first, second);
-    }
-    return first.max_angle_ >= second.min_angle_;
+  bool Contains(const Coord& point) const noexcept {
+    return point.x >= begin.x && point.y >= begin.y && point.x < end.x &&
+           point.y < end.y;
   }
 };
 
@@ -146,157 +91,284 @@ void UpdateConnection(Deviation& deviation, Movement& restr_move,
   }
 }
 
-KRange GetKRange(const Segment& segment) {
-  if (segment.GetA() == segment.GetB()) {
-    return KRange();
-  }
-  double min_angle = TanToDeg(GetKCoefficient(segment));
-  double max_angle = min_angle;
-
-  for (const auto& coord : GetNeighbours(segment.GetB())) {
-    double segm_angle = TanToDeg(GetKCoefficient({segment.GetA(), coord}));
-    min_angle = std::min(min_angle, segm_angle);
-    max_angle = std::max(max_angle, segm_angle);
-  }
-  return KRange(min_angle, max_angle);
-}
-
-struct RecurseRet {
-  std::list<BaseSegment> cont;
-  std::list<BaseSegment> other;
+// Raw segments keep their points in a node pool, chained from the front to
+// the back, so prepending a point and moving segments between lists never
+// allocate.
+struct PointNode {
+  Coord point;
+  int32_t next;
+};
+struct RawSegment {
+  int32_t front;
+  Coord back;
+  int32_t next;
 };
-struct InputData {
+struct RawList {
+  int32_t head = -1;
+  int32_t tail = -1;
+};
+
+template <typename KRange>
+struct Frame {
   Coord curr_point;
   KRange k_range;
   Deviation deviation = {Neutral, Neutral};
   Movement restr_move = None;
   Coord init_point = {0, 0};
 
-  RecurseRet* parent_ret;
-};
-
-struct GlobalVars {
+  int32_t parent = -1;
+  RawList cont = {};
+  RawList other = {};
   bool is_cont = false;
   bool process_ret = false;
 };
 
-struct StackData {
-  InputData input;
-  RecurseRet my_ret;
-  GlobalVars global_vars;
+// telemetry of a thread, only gathered when the extraction reports stats
+struct WorkerStats {
+  int thread = 0;
+  std::chrono::steady_clock::time_point origin;
+  size_t pixels_visited = 0;
+  size_t max_stack_depth = 0;
+  size_t raw_segments = 0;
+  size_t merge_attempts = 0;
+  size_t merges = 0;
+  std::vector<ExtractEvent> events;
+
+  void Reset(std::chrono::steady_clock::time_point start) {
+    origin = start;
+    pixels_visited = 0;
+    max_stack_depth = 0;
+    raw_segments = 0;
+    merge_attempts = 0;
+    merges = 0;
+    events.clear();
+  }
+};
+
+// records the time from its construction to its destruction as an event of
+// the phase, does nothing unless kStats
+template <bool kStats>
+class PhaseScope {
+ public:
+  PhaseScope(WorkerStats& /*stats*/, const char* /*phase*/) {}
+};
+
+template <>
+class PhaseScope<true> {
+ public:
+  PhaseScope(WorkerStats& stats, const char* phase)
+      : stats_(stats), phase_(phase), start_(Clock::now()) {}
+  ~PhaseScope() {
+    auto end = Clock::now();
+    stats_.events.push_back({phase_, stats_.thread, Micros(start_),
+                             Micros(end) - Micros(start_)});
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  WorkerStats& stats_;
+  const char* phase_;
+  Clock::time_point start_;
+
+  double Micros(Clock::time_point time) const {
+    return std::chrono::duration<double, std::micro>(time - stats_.origin)
+        .count();
+  }
+};
+
+struct SCont {
+  Segment segment;
+  Deviation deviation;
+  Movement rest_move;
+};
+using SContList = CountedList<SCont>;
+
+using EndpointMap = EndpointIndex<SContList::iterator>;
+
+// buffers of the traversal and of the merging, reused for every seed and
+// every region handled by a thread
+template <typename KRange>
+struct Workspace {
+  AllocationCounter counter;
+  WorkerStats stats;
+  CountedVector<Frame<KRange>> stack;
+  CountedVector<PointNode> nodes;
+  CountedVector<RawSegment> segments;
+  EndpointMap endpoints;
+  // the bitmap of the component being extracted, only ever grown
+  Bitmap component;
+
+  Workspace()
+      : stack(CountingAllocator<Frame<KRange>>(&counter)),
+        nodes(CountingAllocator<PointNode>(&counter)),
+        segments(CountingAllocator<RawSegment>(&counter)),
+        endpoints(0, &counter) {}
+
+  Workspace(const Workspace&) = delete;
+  Workspace& operator=(const Workspace&) = delete;
+
+  Bitmap& ComponentBitmap(const Coord& size) {
+    auto capacity = component.Capacity();
+    component.Reshape(size.x, size.y);
+    if (component.Capacity() != capacity) {
+      counter.Count(component.Capacity() * sizeof(Bitmap::Word));
+    }
+    return component;
+  }
+
+  int32_t NewSegment(const Coord& point) {
+    nodes.push_back({point, -1});
+    segments.push_back({static_cast<int32_t>(nodes.size() - 1), point, -1});
+    return static_cast<int32_t>(segments.size() - 1);
+  }
+  void PushFront(int32_t segm, const Coord& point) {
+    nodes.push_back({point, segments[segm].front});
+    segments[segm].front = static_cast<int32_t>(nodes.size() - 1);
+  }
+  const Coord& Front(int32_t segm) const {
+    return nodes[segments[segm].front].point;
+  }
+
+  void Append(RawList& list, int32_t segm) {
+    segments[segm].next = -1;
+    if (list.tail == -1) {
+      list.head = segm;
+    } else {
+      segments[list.tail].next = segm;
+    }
+    list.tail = segm;
+  }
+  void Splice(RawList& list, RawList& other) {
+    if (other.head == -1) {
+      return;
+    }
+    if (list.tail == -1) {
+      list.head = other.head;
+    } else {
+      segments[list.tail].next = other.head;
+    }
+    list.tail = other.tail;
+    other = {};
+  }
 };
 
-std::list<BaseSegment> BaseSegmentsGetter(
-    std::vector<std::vector<bool>>& bitmap, const Coord& in_curr_point) {
-  RecurseRet recurse_ret;
+int64_t GetSqrDistance(const Coord& first, const Coord& second) noexcept {
+  int64_t d_x = second.x - first.x;
+  int64_t d_y = second.y - first.y;
+  return d_x * d_x + d_y * d_y;
+}
 
-  std::stack<StackData> stack;
-  stack.push({.input = {.curr_point = in_curr_point,
-                        .k_range = KRange(true),
-                        .parent_ret = &recurse_ret}});
+// appends raw segments grown from the point to the result
+template <typename KRange, bool kStats>
+void BaseSegmentsGetter(Bitmap& bitmap, const Coord& in_curr_point,
+                        const Region& region, Workspace<KRange>& workspace,
+                        RawList& result) {
+  auto& stack = workspace.stack;
+  RawList root_cont;
+
+  stack.clear();
+  stack.push_back({.curr_point = in_curr_point, .k_range = KRange(true)});
+  if constexpr (kStats) {
+    ++workspace.stats.pixels_visited;
+  }
 
   while (!stack.empty()) {
-    auto& input = stack.top().input;
-    auto& ret_cont = stack.top().my_ret;
-    auto& vars = stack.top().global_vars;
-
-    if (!vars.process_ret) {
-      auto init_k = GetKCoefficient({input.init_point, input.curr_point});
-      if (input.k_range.InRange(init_k)) {
-        input.k_range.Intersect(
-            GetKRange({input.init_point, input.curr_point}));
-        vars.is_cont = true;
+    auto curr_ind = static_cast<int32_t>(stack.size() - 1);
+    auto& frame = stack.back();
+
+    if (!frame.process_ret) {
+      if (frame.k_range.InRange({frame.init_point, frame.curr_point})) {
+        frame.k_range.Intersect(
+            KRange::FromSegment({frame.init_point, frame.curr_point}));
+        frame.is_cont = true;
       } else {
-        input.init_point = input.curr_point;
-        input.k_range = KRange();
-        input.deviation = {Neutral, Neutral};
-        input.restr_move = None;
+        frame.init_point = frame.curr_point;
+        frame.k_range = KRange();
+        frame.deviation = {Neutral, Neutral};
+        frame.restr_move = None;
       }
-
-      for (auto neighbour :
-           GetNeighbours(input.curr_point, bitmap.size(), bitmap[0].size())) {
-        if (!bitmap[neighbour.x][neighbour.y] ||
+      frame.process_ret = true;
+
+      // the stack may grow, so the frame is not referenced from here
+      auto input = frame;
+      for (const auto& offset : kNeighbourOffsets) {
+        Coord neighbour = {input.curr_point.x + offset.x,
+                           input.curr_point.y + offset.y};
+        if (!region.Contains(neighbour) ||
+            !bitmap.Get(neighbour.x, neighbour.y) ||
             !CanBeConnected(input.curr_point, neighbour, input.deviation,
                             input.restr_move)) {
           continue;
         }
 
-        bitmap[neighbour.x][neighbour.y] = false;
-
-        StackData local_data;
-        local_data.input = {.curr_point = neighbour,
-                            .k_range = input.k_range,
-                            .init_point = input.init_point,
-                            .parent_ret = &ret_cont};
-        local_data.input.deviation = input.deviation;
-        local_data.input.restr_move = input.restr_move;
-        UpdateConnection(local_data.input.deviation,
-                         local_data.input.restr_move, input.curr_point,
-                         neighbour);
-        stack.push(local_data);
+        bitmap.Reset(neighbour.x, neighbour.y);
+
+        Frame<KRange> local_frame = {.curr_point = neighbour,
+                                     .k_range = input.k_range,
+                                     .deviation = input.deviation,
+                                     .restr_move = input.restr_move,
+                                     .init_point = input.init_point,
+                                     .parent = curr_ind};
+        UpdateConnection(local_frame.deviation, local_frame.restr_move,
+                         input.curr_point, neighbour);
+        stack.push_back(local_frame);
+        if constexpr (kStats) {
+          ++workspace.stats.pixels_visited;
+          workspace.stats.max_stack_depth =
+              std::max(workspace.stats.max_stack_depth, stack.size());
+        }
       }
-
-      vars.process_ret = true;
     } else {
-      double cont_len = -1;
-      auto cont_iter = ret_cont.cont.begin();
-
-      for (auto iter = ret_cont.cont.begin(); iter != ret_cont.cont.end();
-           ++iter) {
-        auto segm_len =
-            iter->empty() ? -1 : GetDistance(iter->front(), iter->back());
+      auto& parent_cont =
+          frame.parent == -1 ? root_cont : stack[frame.parent].cont;
+      auto& parent_other =
+          frame.parent == -1 ? result : stack[frame.parent].other;
+
+      int64_t cont_len = -1;
+      int32_t cont_segm = -1;
+      int32_t cont_prev = -1;
+
+      for (int32_t prev = -1, segm = frame.cont.head; segm != -1;
+           prev = segm, segm = workspace.segments[segm].next) {
+        auto segm_len = GetSqrDistance(workspace.Front(segm),
+                                       workspace.segments[segm].back);
         if (segm_len > cont_len) {
           cont_len = segm_len;
-          cont_iter = iter;
+          cont_segm = segm;
+          cont_prev = prev;
         }
       }
-      if (cont_len >= 0) {
-        auto cont = std::move(*cont_iter);
-        ret_cont.cont.erase(cont_iter);
-        cont.push_front(input.curr_point);
-        if (vars.is_cont) {
-          input.parent_ret->cont.push_back(std::move(cont));
+
+      if (cont_segm != -1) {
+        auto next = workspace.segments[cont_segm].next;
+        if (cont_prev == -1) {
+          frame.cont.head = next;
         } else {
-          input.parent_ret->other.push_back(std::move(cont));
+          workspace.segments[cont_prev].next = next;
+        }
+        if (frame.cont.tail == cont_segm) {
+          frame.cont.tail = cont_prev;
         }
-      } else if (vars.is_cont) {
-        input.parent_ret->cont.push_back({input.curr_point});
+        workspace.PushFront(cont_segm, frame.curr_point);
       } else {
-        input.parent_ret->other.push_back({input.curr_point});
+        cont_segm = workspace.NewSegment(frame.curr_point);
       }
+      workspace.Append(frame.is_cont ? parent_cont : parent_other, cont_segm);
 
-      for (auto&& cont : ret_cont.cont) {
-        input.parent_ret->other.push_back(std::move(cont));
-      }
-      for (auto&& cont : ret_cont.other) {
-        input.parent_ret->other.push_back(std::move(cont));
-      }
-      stack.pop();
+      workspace.Splice(parent_other, frame.cont);
+      workspace.Splice(parent_other, frame.other);
+      stack.pop_back();
     }
   }
-
-  return recurse_ret.other;
 }
 
-struct BSCont {
-  BaseSegment base_segment;
-  Deviation deviation;
-  Movement rest_move;
-};
-
-struct SCont {
-  Segment segment;
-  Deviation deviation;
-  Movement rest_move;
-};
-
+template <typename KRange>
 bool CanBeConnected(const SCont& first, const SCont& second) {
-  if (!GetKRange({first.segment.GetA(), first.segment.GetB()})
-           .InRange(GetKCoefficient(
-               {first.segment.GetA(), second.segment.GetB()})) ||
-      !GetKRange({second.segment.GetB(), second.segment.GetA()})
-           .InRange(GetKCoefficient(
-               {second.segment.GetB(), first.segment.GetA()}))) {
+  if (!KRange::FromSegment({first.segment.GetA(), first.segment.GetB()})
+           .InRange({first.segment.GetA(), second.segment.GetB()}) ||
+      !KRange::FromSegment({second.segment.GetB(), second.segment.GetA()})
+           .InRange({second.segment.GetB(), first.segment.GetA()})) {
     return false;
   }
 
@@ -348,22 +420,26 @@ Deviation ReverseDeviation(Deviation deviation) {
   return deviation;
 }
 
-std::pair<bool, std::list<SCont>::iterator> UniteNeighbours(
-    SCont cont, std::list<SCont>& segments,
-    std::vector<std::vector<std::optional<std::list<SCont>::iterator>>>&
-        bitmap) {
+template <typename KRange, bool kStats>
+std::pair<bool, SContList::iterator> UniteNeighbours(SCont cont,
+                                                     SContList& segments,
+                                                     EndpointMap& endpoints,
+                                                     WorkerStats& stats) {
   auto& [segm, dev, restr_move] = cont;
   Coord conn_point = segm.GetB();
-  auto iter = bitmap[conn_point.x][conn_point.y].value();
+  auto iter = *endpoints.Find(conn_point);
 
-  for (auto neighbour :
-       GetNeighbours(conn_point, bitmap.size(), bitmap[0].size())) {
-    if (!bitmap[neighbour.x][neighbour.y].has_value() ||
-        !CanBeConnected(conn_point, neighbour, dev, restr_move)) {
+  for (const auto& offset : kNeighbourOffsets) {
+    Coord neighbour = {conn_point.x + offset.x, conn_point.y + offset.y};
+    if (!CanBeConnected(conn_point, neighbour, dev, restr_move)) {
+      continue;
+    }
+    auto* found = endpoints.Find(neighbour);
+    if (found == nullptr) {
       continue;
     }
 
-    auto neighbour_iter = bitmap[neighbour.x][neighbour.y].value();
+    auto neighbour_iter = *found;
     if (neighbour_iter == iter) {
       continue;
     }
@@ -376,9 +452,15 @@ std::pair<bool, std::list<SCont>::iterator> UniteNeighbours(
       n_dev = ReverseDeviation(n_dev);
     }
 
-    if (!CanBeConnected(cont, n_cont)) {
+    if constexpr (kStats) {
+      ++stats.merge_attempts;
+    }
+    if (!CanBeConnected<KRange>(cont, n_cont)) {
       continue;
     }
+    if constexpr (kStats) {
+      ++stats.merges;
+    }
 
     auto [u_dev, u_restr_move] =
         UniteConnections(dev, restr_move, n_dev, n_restr_move);
@@ -387,12 +469,12 @@ std::pair<bool, std::list<SCont>::iterator> UniteNeighbours(
     dev = u_dev;
     restr_move = u_restr_move;
 
-    bitmap[neighbour.x][neighbour.y].reset();
-    bitmap[conn_point.x][conn_point.y].reset();
+    endpoints.Erase(neighbour);
+    endpoints.Erase(conn_point);
 
     segments.push_back(cont);
-    bitmap[segm.GetA().x][segm.GetA().y] = std::prev(segments.end());
-    bitmap[segm.GetB().x][segm.GetB().y] = std::prev(segments.end());
+    endpoints.Set(segm.GetA(), std::prev(segments.end()));
+    endpoints.Set(segm.GetB(), std::prev(segments.end()));
 
     segments.erase(neighbour_iter);
     return {true, segments.erase(iter)};
@@ -401,76 +483,814 @@ std::pair<bool, std::list<SCont>::iterator> UniteNeighbours(
   return {false, std::next(iter)};
 }
 
-std::list<Segment> BaseExtractPrimitives(
-    std::vector<std::vector<bool>>& bitmap) {
-  Coord size = {static_cast<int>(bitmap.size()),
-                static_cast<int>(bitmap[0].size())};
+template <typename KRange, bool kStats, typename Filter>
+void ConnectSegments(SContList& segments, EndpointMap& endpoints,
+                     WorkerStats& stats, Filter filter) {
+  for (auto iter = segments.begin(); iter != segments.end();) {
+    if (!filter(*iter)) {
+      ++iter;
+      continue;
+    }
 
-  std::list<BSCont> raw_segments;
+    auto [connected, new_iter] =
+        UniteNeighbours<KRange, kStats>(*iter, segments, endpoints, stats);
+    if (connected) {
+      iter = new_iter;
+      continue;
+    }
+
+    auto cont = *iter;
+    std::swap(cont.segment.GetA(), cont.segment.GetB());
+    cont.deviation = ReverseDeviation(cont.deviation);
+
+    iter = UniteNeighbours<KRange, kStats>(cont, segments, endpoints, stats)
+               .second;
+  }
+}
+
+// the set pixels of the region, transposed: row x of the result holds
+// column x of the region
+Bitmap TransposeRegion(const Bitmap& bitmap, const Region& region) {
+  Bitmap columns(region.end.y - region.begin.y, region.end.x - region.begin.x);
+  for (int y = region.begin.y; y < region.end.y; ++y) {
+    for (int x = region.begin.x; bitmap.FindNextInRow(x, y, region.end.x);
+         ++x) {
+      columns.Set(y - region.begin.y, x - region.begin.x);
+    }
+  }
+  return columns;
+}
+
+template <typename KRange, bool kStats>
+SContList ExtractRegion(Bitmap& bitmap, const Region& region,
+                        Workspace<KRange>& workspace,
+                        SeedOrder order = SeedOrder::kRows) {
+  workspace.nodes.clear();
+  workspace.segments.clear();
+
+  RawList raw_segments;
 
   // getting extracted raw segments
-  for (int x = 0; x < size.x; ++x) {
-    for (int y = 0; y < size.y; ++y) {
-      if (!bitmap[x][y]) {
-        continue;
+  {
+    PhaseScope<kStats> phase(workspace.stats, "traversal");
+    auto grow = [&](int x, int y) {
+      bitmap.Reset(x, y);
+      BaseSegmentsGetter<KRange, kStats>(bitmap, {x, y}, region, workspace,
+                                         raw_segments);
+    };
+    if (order == SeedOrder::kColumns) {
+      // columns are scanned in a copy, the pixels taken by earlier seeds are
+      // gone from the bitmap only
+      auto columns = TransposeRegion(bitmap, region);
+      for (int x = 0; x < columns.SizeY(); ++x) {
+        for (int y = 0; columns.FindNextInRow(y, x, columns.SizeX()); ++y) {
+          if (bitmap.Get(region.begin.x + x, region.begin.y + y)) {
+            grow(region.begin.x + x, region.begin.y + y);
+          }
+        }
+      }
+    } else {
+      for (int y = region.begin.y; y < region.end.y; ++y) {
+        for (int x = region.begin.x;
+             bitmap.FindNextInRow(x, y, region.end.x); ++x) {
+          grow(x, y);
+        }
+      }
+    }
+  }
+  if constexpr (kStats) {
+    workspace.stats.raw_segments += workspace.segments.size();
+  }
+
+  SContList processed_raws{CountingAllocator<SCont>(&workspace.counter)};
+  {
+    PhaseScope<kStats> phase(workspace.stats, "deviations");
+    for (auto segm = raw_segments.head; segm != -1;
+         segm = workspace.segments[segm].next) {
+      // calculating deviation and restricted moves
+      Deviation dev = {Neutral, Neutral};
+      Movement restr_move = None;
+
+      for (auto node = workspace.segments[segm].front;
+           workspace.nodes[node].next != -1;
+           node = workspace.nodes[node].next) {
+        if (dev.first != Neutral && dev.second != Neutral &&
+            restr_move != None) {
+          break;
+        }
+        UpdateConnection(dev, restr_move, workspace.nodes[node].point,
+                         workspace.nodes[workspace.nodes[node].next].point);
+      }
+
+      processed_raws.push_back(
+          {Segment(workspace.Front(segm), workspace.segments[segm].back), dev,
+           restr_move});
+    }
+  }
+
+  auto& endpoints = workspace.endpoints;
+  endpoints.Reset(2 * workspace.segments.size());
+  {
+    PhaseScope<kStats> phase(workspace.stats, "indexing");
+    for (auto iter = processed_raws.begin(); iter != processed_raws.end();
+         ++iter) {
+      endpoints.Set(iter->segment.GetA(), iter);
+      endpoints.Set(iter->segment.GetB(), iter);
+    }
+  }
+
+  // connecting
+  {
+    PhaseScope<kStats> phase(workspace.stats, "merging");
+    ConnectSegments<KRange, kStats>(processed_raws, endpoints, workspace.stats,
+                                    [](const SCont&) { return true; });
+  }
+
+  return processed_raws;
+}
+
+// extracts the component from a bitmap of its bounding box, components never
+// touch each other, so the segments are the ones of the whole bitmap
+template <typename KRange, bool kStats>
+SContList ExtractComponent(const Components& components, int index,
+                           Workspace<KRange>& workspace,
+                           SeedOrder order = SeedOrder::kRows) {
+  const auto& component = components.list[index];
+  Coord size = {component.end.x - component.begin.x,
+                component.end.y - component.begin.y};
+
+  auto& bitmap = workspace.ComponentBitmap(size);
+  for (auto run = component.runs_begin; run < component.runs_end; ++run) {
+    const auto& [y, x_begin, x_end] = components.runs[run];
+    bitmap.SetRange(y - component.begin.y, x_begin - component.begin.x,
+                    x_end - component.begin.x);
+  }
+
+  auto segments =
+      ExtractRegion<KRange, kStats>(bitmap, {{0, 0}, size}, workspace, order);
+  for (auto& cont : segments) {
+    for (auto* point : {&cont.segment.GetA(), &cont.segment.GetB()}) {
+      point->x += component.begin.x;
+      point->y += component.begin.y;
+    }
+  }
+  return segments;
+}
+
+// joins segments across seams, only the ones having an end on a seam row or
+// column take part in it
+template <typename KRange, bool kStats, typename OnSeam>
+void StitchSeams(SContList& segments, OnSeam on_seam,
+                 Workspace<KRange>& workspace) {
+  PhaseScope<kStats> phase(workspace.stats, "stitching");
+
+  auto has_seam_end = [&on_seam](const SCont& cont) {
+    return on_seam(cont.segment.GetA()) || on_seam(cont.segment.GetB());
+  };
+
+  size_t seam_segments = 0;
+  for (const auto& cont : segments) {
+    seam_segments += has_seam_end(cont) ? 1 : 0;
+  }
+
+  auto& endpoints = workspace.endpoints;
+  endpoints.Reset(2 * seam_segments);
+  for (auto iter = segments.begin(); iter != segments.end(); ++iter) {
+    if (has_seam_end(*iter)) {
+      endpoints.Set(iter->segment.GetA(), iter);
+      endpoints.Set(iter->segment.GetB(), iter);
+    }
+  }
+
+  ConnectSegments<KRange, kStats>(segments, endpoints, workspace.stats,
+                                  has_seam_end);
+}
+
+// joins segments of neighbouring tiles
+template <typename KRange, bool kStats>
+void StitchTiles(SContList& segments, const Coord& size,
+                 const Coord& tile_size, Workspace<KRange>& workspace) {
+  StitchSeams<KRange, kStats>(
+      segments,
+      [&size, &tile_size](const Coord& point) {
+        return (point.x % tile_size.x == 0 && point.x != 0) ||
+               (point.x % tile_size.x == tile_size.x - 1 &&
+                point.x != size.x - 1) ||
+               (point.y % tile_size.y == 0 && point.y != 0) ||
+               (point.y % tile_size.y == tile_size.y - 1 &&
+                point.y != size.y - 1);
+      },
+      workspace);
+}
+
+// sums up the telemetry of the threads
+void GatherStats(const std::vector<const WorkerStats*>& workers,
+                 ExtractStats& stats) {
+  for (const auto* worker : workers) {
+    stats.pixels_visited += worker->pixels_visited;
+    stats.max_stack_depth =
+        std::max(stats.max_stack_depth, worker->max_stack_depth);
+    stats.raw_segments += worker->raw_segments;
+    stats.merge_attempts += worker->merge_attempts;
+    stats.merges += worker->merges;
+    stats.events.insert(stats.events.end(), worker->events.begin(),
+                        worker->events.end());
+  }
+  std::stable_sort(stats.events.begin(), stats.events.end(),
+                   [](const ExtractEvent& first, const ExtractEvent& second) {
+                     return first.start_us < second.start_us;
+                   });
+}
+
+// State of the extraction of bitmaps of one size, kept from one bitmap to the
+// next. Buffers, list nodes and threads are reused, so that extracting from
+// similar bitmaps stops allocating.
+template <typename KRange, bool kStats>
+class Extraction {
+ public:
+  Extraction(const Coord& size, const ExtractParams& params)
+      : size_(size),
+        params_(params),
+        workspaces_(std::max(params.threads, 1)),
+        processed_raws_(CountingAllocator<SCont>(&workspaces_[0].counter)),
+        tile_size_(TileSize(params)),
+        tiles_(Tiles(size, tile_size_)),
+        region_segments_(CountingAllocator<SContList>(&workspaces_[0].counter)),
+        components_(&workspaces_[0].counter),
+        order_(CountingAllocator<int>(&workspaces_[0].counter)),
+        thread_pool_(PoolSize(params, tiles_.size())) {
+    for (int thread = 0; thread < static_cast<int>(workspaces_.size());
+         ++thread) {
+      workspaces_[thread].stats.thread = thread;
+      if (thread_pool_.Size() > 1) {
+        workspaces_[thread].counter.SetPool(&node_pool_);
+      }
+    }
+    region_segments_.resize(tiles_.size(),
+                            SContList(processed_raws_.get_allocator()));
+  }
+
+  Extraction(const Extraction&) = delete;
+  Extraction& operator=(const Extraction&) = delete;
+
+  // the segments are valid until the next run
+  const std::vector<Segment>& Run(Bitmap& bitmap) {
+    Totals before = kStats ? Allocated() : Totals{};
+    if constexpr (kStats) {
+      auto origin = std::chrono::steady_clock::now();
+      for (auto& workspace : workspaces_) {
+        workspace.stats.Reset(origin);
       }
-      bitmap[x][y] = false;
+    }
 
-      auto base_segments = BaseSegmentsGetter(bitmap, {x, y});
+    if (params_.tile_size <= 0 && params_.split_components) {
+      ExtractComponents(bitmap);
+    } else if (params_.tile_size <= 0) {
+      processed_raws_.splice(
+          processed_raws_.cend(),
+          ExtractRegion<KRange, kStats>(bitmap, {{0, 0}, size_},
+                                        workspaces_[0], params_.seed_order));
+    } else {
+      ShareNodes();
+      thread_pool_.ParallelFor(
+          static_cast<int>(tiles_.size()), [&](int index, int worker) {
+            region_segments_[index] = ExtractRegion<KRange, kStats>(
+                bitmap, tiles_[index], workspaces_[worker],
+                params_.seed_order);
+          });
+
+      for (auto& segments : region_segments_) {
+        processed_raws_.splice(processed_raws_.cend(), segments);
+      }
+      StitchTiles<KRange, kStats>(processed_raws_, size_, tile_size_,
+                                  workspaces_[0]);
+    }
 
-      for (auto&& base : base_segments) {
-        raw_segments.push_back({std::move(base), {Neutral, Neutral}, None});
+    if constexpr (kStats) {
+      auto after = Allocated();
+      std::vector<const WorkerStats*> workers;
+      for (const auto& workspace : workspaces_) {
+        workers.push_back(&workspace.stats);
       }
+
+      *params_.stats = {};
+      params_.stats->allocations = after.allocations - before.allocations;
+      params_.stats->allocated_bytes = after.bytes - before.bytes;
+      params_.stats->segments = processed_raws_.size();
+      GatherStats(workers, *params_.stats);
+    }
+
+    segments_.clear();
+    for (const auto& segm : processed_raws_) {
+      segments_.push_back(segm.segment);
     }
+    processed_raws_.clear();
+    return segments_;
   }
 
-  // calculating deviation and restricted moves
-  for (auto& [base, dev, restr_move] : raw_segments) {
-    for (auto iter = std::next(base.begin()); iter != base.end(); ++iter) {
-      if (dev.first != Neutral && dev.second != Neutral && restr_move != None) {
-        break;
+ private:
+  struct Totals {
+    size_t allocations = 0;
+    size_t bytes = 0;
+  };
+
+  Coord size_;
+  ExtractParams params_;
+  // list nodes shared by the threads, it never allocates
+  AllocationCounter node_pool_;
+  std::vector<Workspace<KRange>> workspaces_;
+  // its nodes are freed to the first workspace
+  SContList processed_raws_;
+  Coord tile_size_;
+  std::vector<Region> tiles_;
+  // segments of every tile or component
+  CountedVector<SContList> region_segments_;
+  Components components_;
+  CountedVector<int> order_;
+  ThreadPool thread_pool_;
+  std::vector<Segment> segments_;
+
+  // tile columns are word aligned, so tiles never share bitmap words
+  static Coord TileSize(const ExtractParams& params) {
+    return {(params.tile_size + Bitmap::kWordBits - 1) / Bitmap::kWordBits *
+                Bitmap::kWordBits,
+            params.tile_size};
+  }
+
+  static std::vector<Region> Tiles(const Coord& size, const Coord& tile_size) {
+    std::vector<Region> tiles;
+    if (tile_size.y <= 0) {
+      return tiles;
+    }
+    for (int y = 0; y < size.y; y += tile_size.y) {
+      for (int x = 0; x < size.x; x += tile_size.x) {
+        tiles.push_back({{x, y},
+                         {std::min(x + tile_size.x, size.x),
+                          std::min(y + tile_size.y, size.y)}});
       }
-      UpdateConnection(dev, restr_move, *std::prev(iter), *iter);
     }
+    return tiles;
   }
 
-  std::list<SCont> processed_raws;
+  static int PoolSize(const ExtractParams& params, size_t tiles) {
+    if (params.tile_size > 0) {
+      return std::max(std::min(params.threads, static_cast<int>(tiles)), 1);
+    }
+    return params.split_components ? std::max(params.threads, 1) : 1;
+  }
 
-  using ConnBitmapType = std::optional<decltype(processed_raws)::iterator>;
-  std::vector<std::vector<ConnBitmapType>> conn_bitmap(
-      size.x, std::vector<ConnBitmapType>(size.y));
+  Totals Allocated() const {
+    Totals totals;
+    for (const auto& workspace : workspaces_) {
+      totals.allocations += workspace.counter.allocations;
+      totals.bytes += workspace.counter.bytes;
+    }
+    return totals;
+  }
 
-  for (const auto& [base, dev, restr_move] : raw_segments) {
-    processed_raws.push_back(
-        {Segment(base.front(), base.back()), dev, restr_move});
-    auto a_point = processed_raws.back().segment.GetA();
-    auto b_point = processed_raws.back().segment.GetB();
-    conn_bitmap[a_point.x][a_point.y] = std::prev(processed_raws.end());
-    conn_bitmap[b_point.x][b_point.y] = std::prev(processed_raws.end());
+  // the nodes freed at the end of the last run went to the first workspace,
+  // and the ones left over to the others; they all go to the pool the threads
+  // draw from before they allocate, however unevenly the tiles or components
+  // fall to them
+  void ShareNodes() {
+    if (thread_pool_.Size() > 1) {
+      for (auto& workspace : workspaces_) {
+        workspace.counter.Give(node_pool_);
+      }
+    }
   }
 
-  // connecting
-  for (auto iter = processed_raws.begin(); iter != processed_raws.end();) {
-    auto [connected, new_iter] =
-        UniteNeighbours(*iter, processed_raws, conn_bitmap);
-    if (connected) {
-      iter = new_iter;
-      continue;
+  void ExtractComponents(Bitmap& bitmap) {
+    auto& components = components_;
+    {
+      PhaseScope<kStats> phase(workspaces_[0].stats, "components");
+      FindComponents(bitmap, components);
+    }
+    bitmap.Clear();
+    auto count = static_cast<int>(components.list.size());
+
+    // the largest components go first, so the threads finish together
+    order_.resize(count);
+    std::iota(order_.begin(), order_.end(), 0);
+    // ties keep their order, without the buffer of a stable sort
+    std::sort(order_.begin(), order_.end(), [&](int first, int second) {
+      auto first_pixels = components.list[first].pixels;
+      auto second_pixels = components.list[second].pixels;
+      return first_pixels != second_pixels ? first_pixels > second_pixels
+                                           : first < second;
+    });
+
+    if (region_segments_.size() < static_cast<size_t>(count)) {
+      region_segments_.resize(count,
+                              SContList(processed_raws_.get_allocator()));
+    }
+    ShareNodes();
+    thread_pool_.ParallelFor(count, [&](int index, int worker) {
+      region_segments_[order_[index]] = ExtractComponent<KRange, kStats>(
+          components, order_[index], workspaces_[worker], params_.seed_order);
+    });
+
+    for (int index = 0; index < count; ++index) {
+      processed_raws_.splice(processed_raws_.cend(), region_segments_[index]);
     }
+  }
+};
 
-    auto cont = *iter;
-    std::swap(cont.segment.GetA(), cont.segment.GetB());
-    cont.deviation = ReverseDeviation(cont.deviation);
+template <typename KRange, bool kStats>
+std::list<Segment> ExtractPrimitivesWith(Bitmap& bitmap,
+                                         const ExtractParams& params) {
+  Extraction<KRange, kStats> extraction({bitmap.SizeX(), bitmap.SizeY()},
+                                        params);
+  const auto& segments = extraction.Run(bitmap);
+  return {segments.begin(), segments.end()};
+}
 
-    iter = UniteNeighbours(cont, processed_raws, conn_bitmap).second;
+class Extractor::Impl {
+ public:
+  template <typename Kind>
+  Impl(std::in_place_type_t<Kind> kind, const Coord& size,
+       const ExtractParams& params)
+      : extraction_(kind, size, params) {}
+
+  const std::vector<Segment>& Extract(Bitmap& frame) {
+    return std::visit(
+        [&frame](auto& extraction) -> const std::vector<Segment>& {
+          return extraction.Run(frame);
+        },
+        extraction_);
   }
 
-  std::list<Segment> segments;
-  for (auto segm : processed_raws) {
-    segments.push_back(segm.segment);
+ private:
+  std::variant<Extraction<ConeKRange, false>, Extraction<ConeKRange, true>,
+               Extraction<DegKRange, false>, Extraction<DegKRange, true>>
+      extraction_;
+};
+
+std::unique_ptr<Extractor::Impl> Extractor::MakeImpl(
+    const Coord& size, const ExtractParams& params) {
+  bool stats = params.stats != nullptr;
+  if (params.k_range_mode == KRangeMode::kReference) {
+    return stats ? std::make_unique<Impl>(
+                       std::in_place_type<Extraction<DegKRange, true>>, size,
+                       params)
+                 : std::make_unique<Impl>(
+                       std::in_place_type<Extraction<DegKRange, false>>, size,
+                       params);
   }
+  return stats ? std::make_unique<Impl>(
+                     std::in_place_type<Extraction<ConeKRange, true>>, size,
+                     params)
+               : std::make_unique<Impl>(
+                     std::in_place_type<Extraction<ConeKRange, false>>, size,
+                     params);
+}
 
-  return segments;
+Extractor::Extractor(int size_x, int size_y, const ExtractParams& params)
+    : impl_(MakeImpl({size_x, size_y}, params)), frame_(size_x, size_y) {}
+
+Extractor::~Extractor() = default;
+Extractor::Extractor(Extractor&&) noexcept = default;
+Extractor& Extractor::operator=(Extractor&&) noexcept = default;
+
+const std::vector<Segment>& Extractor::Extract(Bitmap& frame) {
+  if (frame.SizeX() != SizeX() || frame.SizeY() != SizeY()) {
+    throw std::runtime_error("Frame size mismatch");
+  }
+  return impl_->Extract(frame);
+}
+
+// The segments of every component are kept by the index of its first pixel,
+// in row-major order. An update takes the components next to the dirty
+// rectangles out of the bitmap twice: before the edit, to drop the segments
+// of the old ones, and after it, to extract the new ones. Any component
+// changed by the edit is next to a dirty rectangle before and after it, and
+// the others keep their pixels, so their segments are still right. Taking
+// components costs about as much as finding all of them, so once the ones
+// next to the edit hold more than 1 / kRebuildShare of the runs, the first
+// taking stops and all of them are found and extracted again instead.
+template <typename KRange>
+class IncrementalExtraction {
+ public:
+  static constexpr size_t kRebuildShare = 4;
+
+  explicit IncrementalExtraction(const Bitmap& image)
+      : bitmap_(image), taken_(&workspace_.counter) {
+    Rebuild();
+  }
+
+  const Bitmap& Image() const { return bitmap_; }
+
+  void Update(const Bitmap& image, const std::vector<Rect>& dirty) {
+    std::vector<Rect> clipped;
+    std::vector<Rect> grown;
+    for (const auto& rect : dirty) {
+      auto clip = [this](const Rect& rect) {
+        return Rect{{std::max(rect.begin.x, 0), std::max(rect.begin.y, 0)},
+                    {std::min(rect.end.x, bitmap_.SizeX()),
+                     std::min(rect.end.y, bitmap_.SizeY())}};
+      };
+      clipped.push_back(clip(rect));
+      grown.push_back(clip({{rect.begin.x - 1, rect.begin.y - 1},
+                            {rect.end.x + 1, rect.end.y + 1}}));
+    }
+
+    // a rebuild reads every row however few runs there are
+    auto max_runs =
+        std::max(runs_, static_cast<size_t>(bitmap_.SizeY())) / kRebuildShare;
+    bool rebuild = !TakeComponents(grown, max_runs);
+    if (!rebuild) {
+      for (const auto& component : taken_.list) {
+        auto kept = segments_.find(Index(taken_.runs[component.runs_begin]));
+        runs_ -= kept->second.runs;
+        segments_.erase(kept);
+      }
+    }
+    RestoreComponents();
+
+    for (const auto& rect : clipped) {
+      for (int y = rect.begin.y; y < rect.end.y; ++y) {
+        for (int x = rect.begin.x; x < rect.end.x; ++x) {
+          bitmap_.Assign(x, y, image.Get(x, y));
+        }
+      }
+    }
+
+    if (rebuild) {
+      Rebuild();
+      return;
+    }
+    TakeComponents(grown);
+    for (int index = 0; index < static_cast<int>(taken_.list.size());
+         ++index) {
+      Add(taken_, index);
+    }
+    RestoreComponents();
+  }
+
+  std::list<Segment> Segments() const {
+    std::list<Segment> segments;
+    for (const auto& [index, kept] : segments_) {
+      segments.insert(segments.end(), kept.segments.begin(),
+                      kept.segments.end());
+    }
+    return segments;
+  }
+
+ private:
+  struct KeptComponent {
+    size_t runs = 0;
+    std::vector<Segment> segments;
+  };
+
+  Bitmap bitmap_;
+  Workspace<KRange> workspace_;
+  std::map<int64_t, KeptComponent> segments_;
+  // runs of all the kept components
+  size_t runs_ = 0;
+  Components taken_;
+
+  int64_t Index(const Run& first_run) const {
+    return static_cast<int64_t>(first_run.y) * bitmap_.SizeX() +
+           first_run.x_begin;
+  }
+
+  void Rebuild() {
+    segments_.clear();
+    runs_ = 0;
+    FindComponents(bitmap_, taken_);
+    for (int index = 0; index < static_cast<int>(taken_.list.size());
+         ++index) {
+      Add(taken_, index);
+    }
+  }
+
+  void Add(const Components& components, int index) {
+    auto segments =
+        ExtractComponent<KRange, false>(components, index, workspace_);
+    const auto& component = components.list[index];
+    auto& kept = segments_[Index(components.runs[component.runs_begin])];
+    kept.runs = component.runs_end - component.runs_begin;
+    runs_ += kept.runs;
+    kept.segments.clear();
+    for (const auto& cont : segments) {
+      kept.segments.push_back(cont.segment);
+    }
+  }
+
+  // the components having a pixel in the rectangles, false when they hold
+  // more than max_runs runs and only some of them were taken
+  bool TakeComponents(const std::vector<Rect>& rects,
+                      size_t max_runs = static_cast<size_t>(-1)) {
+    taken_.runs.clear();
+    taken_.list.clear();
+    for (const auto& rect : rects) {
+      for (int y = rect.begin.y; y < rect.end.y; ++y) {
+        for (int x = rect.begin.x; bitmap_.FindNextInRow(x, y, rect.end.x);) {
+          taken_.list.push_back(
+              TakeComponent(bitmap_, {x, y}, taken_.runs, max_runs));
+          if (taken_.runs.size() > max_runs) {
+            return false;
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  void RestoreComponents() {
+    for (const auto& [y, x_begin, x_end] : taken_.runs) {
+      bitmap_.SetRange(y, x_begin, x_end);
+    }
+  }
+};
+
+class IncrementalExtractor::Impl {
+ public:
+  template <typename Kind>
+  Impl(std::in_place_type_t<Kind> kind, const Bitmap& image)
+      : extraction_(kind, image) {}
+
+  const Bitmap& Image() const {
+    return std::visit(
+        [](const auto& extraction) -> const Bitmap& {
+          return extraction.Image();
+        },
+        extraction_);
+  }
+
+  void Update(const Bitmap& image, const std::vector<Rect>& dirty) {
+    std::visit(
+        [&](auto& extraction) { extraction.Update(image, dirty); },
+        extraction_);
+  }
+
+  std::list<Segment> Segments() const {
+    return std::visit(
+        [](const auto& extraction) { return extraction.Segments(); },
+        extraction_);
+  }
+
+ private:
+  std::variant<IncrementalExtraction<ConeKRange>,
+               IncrementalExtraction<DegKRange>>
+      extraction_;
+};
+
+IncrementalExtractor::IncrementalExtractor(const Bitmap& image,
+                                           const ExtractParams& params)
+    : impl_(params.k_range_mode == KRangeMode::kReference
+                ? std::make_unique<Impl>(
+                      std::in_place_type<IncrementalExtraction<DegKRange>>,
+                      image)
+                : std::make_unique<Impl>(
+                      std::in_place_type<IncrementalExtraction<ConeKRange>>,
+                      image)) {}
+
+IncrementalExtractor::~IncrementalExtractor() = default;
+IncrementalExtractor::IncrementalExtractor(IncrementalExtractor&&) noexcept =
+    default;
+IncrementalExtractor& IncrementalExtractor::operator=(
+    IncrementalExtractor&&) noexcept = default;
+
+const Bitmap& IncrementalExtractor::Image() const { return impl_->Image(); }
+
+void IncrementalExtractor::Update(const Bitmap& image,
+                                  const std::vector<Rect>& dirty) {
+  if (image.SizeX() != Image().SizeX() || image.SizeY() != Image().SizeY()) {
+    throw std::runtime_error("Image size mismatch");
+  }
+  impl_->Update(image, dirty);
+}
+
+std::list<Segment> IncrementalExtractor::Segments() const {
+  return impl_->Segments();
+}
+
+template <typename KRange, bool kStats>
+void StreamExtractWith(int size_x, int size_y, const RowProducer& rows,
+                       const SegmentSink& sink, const ExtractParams& params) {
+  int strip_height =
+      params.tile_size > 0 ? params.tile_size : kDefaultStripHeight;
+  int words = (size_x + Bitmap::kWordBits - 1) / Bitmap::kWordBits;
+  Bitmap::Word last_word_mask =
+      size_x % Bitmap::kWordBits == 0
+          ? ~Bitmap::Word(0)
+          : (Bitmap::Word(1) << (size_x % Bitmap::kWordBits)) - 1;
+
+  Workspace<KRange> workspace;
+  if constexpr (kStats) {
+    workspace.stats.origin = std::chrono::steady_clock::now();
+  }
+  AllocationCounter counter;
+  // segments that may still be joined to the ones of the next strip
+  SContList frontier{CountingAllocator<SCont>(&counter)};
+  Bitmap strip(size_x, std::min(strip_height, size_y));
+  size_t segments_num = 0;
+
+  // strips go down from the top one, rows are asked for as scanners and
+  // files give them
+  for (int y_end = size_y; y_end > 0; y_end -= strip_height) {
+    int height = std::min(strip_height, y_end);
+    int y_begin = y_end - height;
+    for (int y = height - 1; y >= 0; --y) {
+      auto* row = strip.Row(y);
+      rows(y_begin + y, row);
+      row[words - 1] &= last_word_mask;
+    }
+
+    auto segments = ExtractRegion<KRange, kStats>(
+        strip, {{0, 0}, {size_x, height}}, workspace);
+    for (auto& cont : segments) {
+      cont.segment.GetA().y += y_begin;
+      cont.segment.GetB().y += y_begin;
+    }
+    frontier.splice(frontier.cend(), segments);
+    if (y_end < size_y) {
+      StitchSeams<KRange, kStats>(
+          frontier,
+          [y_end](const Coord& point) {
+            return point.y == y_end - 1 || point.y == y_end;
+          },
+          workspace);
+    }
+
+    // nothing but the next seam may join a segment, the ones not touching
+    // it are done
+    bool last_strip = y_begin == 0;
+    for (auto iter = frontier.begin(); iter != frontier.end();) {
+      if (last_strip || (iter->segment.GetA().y != y_begin &&
+                         iter->segment.GetB().y != y_begin)) {
+        sink(iter->segment);
+        ++segments_num;
+        iter = frontier.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
+  if constexpr (kStats) {
+    *params.stats = {};
+    params.stats->allocations =
+        counter.allocations + workspace.counter.allocations;
+    params.stats->allocated_bytes = counter.bytes + workspace.counter.bytes;
+    params.stats->segments = segments_num;
+    GatherStats({&workspace.stats}, *params.stats);
+  }
+}
+
+void StreamExtractPrimitives(int size_x, int size_y, const RowProducer& rows,
+                             const SegmentSink& sink,
+                             const ExtractParams& params) {
+  if (size_x <= 0 || size_y <= 0) {
+    return;
+  }
+  if (params.k_range_mode == KRangeMode::kReference) {
+    params.stats != nullptr
+        ? StreamExtractWith<DegKRange, true>(size_x, size_y, rows, sink, params)
+        : StreamExtractWith<DegKRange, false>(size_x, size_y, rows, sink,
+                                              params);
+    return;
+  }
+  params.stats != nullptr
+      ? StreamExtractWith<ConeKRange, true>(size_x, size_y, rows, sink, params)
+      : StreamExtractWith<ConeKRange, false>(size_x, size_y, rows, sink,
+                                             params);
+}
+
+std::list<Segment> BaseExtractPrimitives(Bitmap& bitmap,
+                                         const ExtractParams& params) {
+  if (bitmap.Empty()) {
+    return {};
+  }
+  // telemetry is compiled out of the extraction nobody asks it from
+  if (params.k_range_mode == KRangeMode::kReference) {
+    return params.stats != nullptr
+               ? ExtractPrimitivesWith<DegKRange, true>(bitmap, params)
+               : ExtractPrimitivesWith<DegKRange, false>(bitmap, params);
+  }
+  return params.stats != nullptr
+             ? ExtractPrimitivesWith<ConeKRange, true>(bitmap, params)
+             : ExtractPrimitivesWith<ConeKRange, false>(bitmap, params);
+}
+
+std::list<Segment> BaseExtractPrimitives(
+    std::vector<std::vector<bool>>& bitmap, const ExtractParams& params) {
+  if (bitmap.empty()) {
+    return {};
+  }
+  Bitmap packed(static_cast<int>(bitmap.size()),
+                static_cast<int>(bitmap[0].size()));
+  for (int x = 0; x < packed.SizeX(); ++x) {
+    for (int y = 0; y < packed.SizeY(); ++y) {
+      if (bitmap[x][y]) {
+        packed.Set(x, y);
+        bitmap[x][y] = false;
+      }
+    }
+  }
+
+  return BaseExtractPrimitives(packed, params);
 }
 
-}  // namespace PTIT
\ No newline at end of file
+}  // namespace PTIT
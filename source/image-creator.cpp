@@ -1,10 +1,136 @@
 #include "image-creator.hpp"
 
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
 namespace PTIT {
 
 bool operator==(const RGB& first, const RGB& second) noexcept {
   return first.red == second.red && first.green == second.green &&
          first.blue == second.blue;
 }
+bool operator==(const RGBA& first, const RGBA& second) noexcept {
+  return first.red == second.red && first.green == second.green &&
+         first.blue == second.blue && first.alpha == second.alpha;
+}
+
+uint8_t* PackPixel(const RGBA& pixel, ImageFormat format, uint8_t* dest) {
+  auto channel = [](short value) {
+    return static_cast<uint8_t>(std::clamp<short>(value, 0, RGB::kMaxColor));
+  };
+
+  if (format == ImageFormat::kPGM) {
+    *dest++ = channel(static_cast<short>(
+        (299 * pixel.red + 587 * pixel.green + 114 * pixel.blue + 500) /
+        1000));
+    return dest;
+  }
+
+  *dest++ = channel(pixel.red);
+  *dest++ = channel(pixel.green);
+  *dest++ = channel(pixel.blue);
+  if (format == ImageFormat::kPAM) {
+    *dest++ = channel(pixel.alpha);
+  }
+  return dest;
+}
+
+ImageWriter::ImageWriter(const char* image_file, ssize_t size_x,
+                         ssize_t size_y, ImageFormat format)
+    : img_file_(image_file, std::ios::binary),
+      size_x_(size_x),
+      format_(format) {
+  if (!img_file_.is_open()) {
+    throw std::runtime_error("Cannot open file");
+  }
+  buffer_.reserve(kBlockSize);
+
+  std::string header;
+  switch (format_) {
+    case ImageFormat::kPlainPPM:
+    case ImageFormat::kPPM:
+    case ImageFormat::kPGM:
+      header = format_ == ImageFormat::kPlainPPM ? "P3\n"
+               : format_ == ImageFormat::kPPM    ? "P6\n"
+                                                 : "P5\n";
+      header += std::to_string(size_x) + " " + std::to_string(size_y) + "\n";
+      header += std::to_string(RGB::kMaxColor) + "\n";
+      break;
+    case ImageFormat::kPAM:
+      header = "P7\nWIDTH " + std::to_string(size_x) + "\nHEIGHT " +
+               std::to_string(size_y) + "\nDEPTH 4\nMAXVAL " +
+               std::to_string(RGB::kMaxColor) +
+               "\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+      break;
+  }
+  buffer_.insert(buffer_.end(), header.begin(), header.end());
+}
+
+ImageWriter::~ImageWriter() {
+  if (img_file_.is_open()) {
+    img_file_.write(buffer_.data(),
+                    static_cast<std::streamsize>(buffer_.size()));
+  }
+}
+
+int ImageWriter::ChannelsNum(ImageFormat format) {
+  switch (format) {
+    case ImageFormat::kPGM:
+      return 1;
+    case ImageFormat::kPAM:
+      return 4;
+    default:
+      return 3;
+  }
+}
+
+void ImageWriter::WriteRow(const uint8_t* row) {
+  size_t row_size = size_x_ * ChannelsNum();
+
+  if (format_ != ImageFormat::kPlainPPM) {
+    if (buffer_.size() + row_size > kBlockSize) {
+      Flush();
+    }
+    if (row_size >= kBlockSize) {
+      img_file_.write(reinterpret_cast<const char*>(row), row_size);
+    } else {
+      buffer_.insert(buffer_.end(), row, row + row_size);
+    }
+    return;
+  }
+
+  // "rrr ggg bbb\n" at most for every pixel
+  const size_t kMaxPixelSize = 12;
+  for (ssize_t x = 0; x < size_x_; ++x) {
+    if (buffer_.size() + kMaxPixelSize > kBlockSize) {
+      Flush();
+    }
+    char text[kMaxPixelSize];
+    char* end = text;
+    for (int channel = 0; channel < 3; ++channel) {
+      // three digits at most, the separator always fits after them
+      end = std::to_chars(end, end + 3, row[3 * x + channel]).ptr;
+      *end++ = channel == 2 ? '\n' : ' ';
+    }
+    buffer_.insert(buffer_.end(), text, end);
+  }
+}
+
+void ImageWriter::Close() {
+  Flush();
+  img_file_.close();
+  if (img_file_.fail()) {
+    throw std::runtime_error("Cannot write file");
+  }
+}
+
+void ImageWriter::Flush() {
+  img_file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  buffer_.clear();
+  if (img_file_.fail()) {
+    throw std::runtime_error("Cannot write file");
+  }
+}
 
-}  // namespace PTIT
\ No newline at end of file
+}  // namespace PTIT
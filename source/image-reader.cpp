@@ -0,0 +1,226 @@
+#include "image-reader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+#include "binarize.hpp"
+
+namespace PTIT {
+
+MappedFile::MappedFile(const char* file) {
+  int descriptor = open(file, O_RDONLY);
+  if (descriptor < 0) {
+    throw std::runtime_error("Cannot open file");
+  }
+  struct stat status;
+  if (fstat(descriptor, &status) != 0) {
+    close(descriptor);
+    throw std::runtime_error("Cannot open file");
+  }
+  size_ = static_cast<size_t>(status.st_size);
+  if (size_ > 0) {
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (data == MAP_FAILED) {
+      close(descriptor);
+      throw std::runtime_error("Cannot map file");
+    }
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const uint8_t*>(data);
+  }
+  close(descriptor);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+}
+
+bool IsSpace(uint8_t symbol) {
+  return symbol == ' ' || symbol == '\t' || symbol == '\n' || symbol == '\r' ||
+         symbol == '\v' || symbol == '\f';
+}
+
+// skips whitespace and comments running to the end of their lines
+const uint8_t* SkipSpaces(const uint8_t* pos, const uint8_t* end) {
+  while (pos != end) {
+    if (*pos == '#') {
+      while (pos != end && *pos != '\n') {
+        ++pos;
+      }
+    } else if (IsSpace(*pos)) {
+      ++pos;
+    } else {
+      break;
+    }
+  }
+  return pos;
+}
+
+const uint8_t* ParseNumber(const uint8_t* pos, const uint8_t* end,
+                           int& value) {
+  auto [ptr, error] =
+      std::from_chars(reinterpret_cast<const char*>(pos),
+                      reinterpret_cast<const char*>(end), value);
+  if (error != std::errc() || value < 0) {
+    throw std::runtime_error("Corrupted image");
+  }
+  return reinterpret_cast<const uint8_t*>(ptr);
+}
+
+NetpbmImage::NetpbmImage(const char* image_file) : file_(image_file) {
+  const uint8_t* pos = file_.Data();
+  const uint8_t* end = pos + file_.Size();
+  if (file_.Size() < 2 || pos[0] != 'P' || pos[1] < '1' || pos[1] > '6') {
+    throw std::runtime_error("Unsupported image format");
+  }
+  int kind = pos[1] - '0';
+  bool plain = kind <= 3;
+  bilevel_ = kind == 1 || kind == 4;
+  channels_ = kind == 3 || kind == 6 ? 3 : 1;
+  pos += 2;
+
+  pos = ParseNumber(SkipSpaces(pos, end), end, size_x_);
+  pos = ParseNumber(SkipSpaces(pos, end), end, size_y_);
+  if (!bilevel_) {
+    pos = ParseNumber(SkipSpaces(pos, end), end, max_value_);
+    if (max_value_ == 0 || max_value_ > 65535) {
+      throw std::runtime_error("Corrupted image");
+    }
+  }
+
+  if (size_x_ == 0 || size_y_ == 0) {
+    throw std::runtime_error("Corrupted image");
+  }
+  int sample_bytes = max_value_ > 255 ? 2 : 1;
+  row_bytes_ = bilevel_ ? (static_cast<size_t>(size_x_) + 7) / 8
+                        : static_cast<size_t>(size_x_) * channels_ *
+                              sample_bytes;
+
+  // row_bytes_ * size_y_ is the size of the raster everywhere below
+  if (row_bytes_ > SIZE_MAX / static_cast<size_t>(size_y_)) {
+    throw std::runtime_error("Corrupted image");
+  }
+
+  if (plain) {
+    ParsePlain(pos, end);
+    raster_ = plain_raster_.data();
+    return;
+  }
+
+  // a single whitespace character separates the header from the raster
+  if (pos == end || !IsSpace(*pos)) {
+    throw std::runtime_error("Corrupted image");
+  }
+  ++pos;
+  if (row_bytes_ > static_cast<size_t>(end - pos) / size_y_) {
+    throw std::runtime_error("Truncated image");
+  }
+  raster_ = pos;
+}
+
+void NetpbmImage::ParsePlain(const uint8_t* pos, const uint8_t* end) {
+  // a pixel of a bilevel image, or a sample of another one, takes at least a
+  // character of the file
+  size_t samples = static_cast<size_t>(size_x_) * (bilevel_ ? 1 : channels_);
+  if (samples > static_cast<size_t>(end - pos) / size_y_) {
+    throw std::runtime_error("Truncated image");
+  }
+  samples *= size_y_;
+  plain_raster_.assign(row_bytes_ * size_y_, 0);
+  auto* dest = plain_raster_.data();
+
+  if (bilevel_) {
+    // digits need no whitespace between them
+    for (int y = 0; y < size_y_; ++y, dest += row_bytes_) {
+      for (int x = 0; x < size_x_; ++x) {
+        pos = SkipSpaces(pos, end);
+        if (pos == end || (*pos != '0' && *pos != '1')) {
+          throw std::runtime_error("Truncated image");
+        }
+        if (*pos++ == '1') {
+          dest[x / 8] |= static_cast<uint8_t>(0x80 >> (x % 8));
+        }
+      }
+    }
+    return;
+  }
+
+  for (size_t index = 0; index < samples; ++index) {
+    pos = SkipSpaces(pos, end);
+    if (pos == end) {
+      throw std::runtime_error("Truncated image");
+    }
+    int value;
+    pos = ParseNumber(pos, end, value);
+    if (value > max_value_) {
+      throw std::runtime_error("Corrupted image");
+    }
+    if (max_value_ > 255) {
+      *dest++ = static_cast<uint8_t>(value >> 8);
+    }
+    *dest++ = static_cast<uint8_t>(value);
+  }
+}
+
+int NetpbmImage::Sample(int x, int y, int channel) const {
+  const auto* row = Row(y);
+  if (bilevel_) {
+    return (row[x / 8] >> (7 - x % 8)) & 1;
+  }
+  size_t index = static_cast<size_t>(x) * channels_ + channel;
+  if (max_value_ > 255) {
+    return row[2 * index] << 8 | row[2 * index + 1];
+  }
+  return row[index];
+}
+
+void NetpbmImage::PackRow(int y, Bitmap::Word* row) const {
+  if (!bilevel_) {
+    throw std::runtime_error("Not a bilevel image");
+  }
+  const auto* source = Row(y);
+  size_t bytes_left = row_bytes_;
+  int words = (size_x_ + Bitmap::kWordBits - 1) / Bitmap::kWordBits;
+  for (int index = 0; index < words; ++index) {
+    size_t bytes = std::min<size_t>(bytes_left, 8);
+    Bitmap::Word word = 0;
+    for (size_t byte = 0; byte < bytes; ++byte) {
+      word |= Bitmap::Word(source[byte]) << (8 * byte);
+    }
+    source += bytes;
+    bytes_left -= bytes;
+
+    // the bits of every byte are reversed in place
+    word = (word & 0xF0F0F0F0F0F0F0F0) >> 4 | (word & 0x0F0F0F0F0F0F0F0F) << 4;
+    word = (word & 0xCCCCCCCCCCCCCCCC) >> 2 | (word & 0x3333333333333333) << 2;
+    word = (word & 0xAAAAAAAAAAAAAAAA) >> 1 | (word & 0x5555555555555555) << 1;
+    row[index] = word;
+  }
+  // padding bits of the file rows are arbitrary
+  if (size_x_ % Bitmap::kWordBits != 0) {
+    row[words - 1] &= (Bitmap::Word(1) << (size_x_ % Bitmap::kWordBits)) - 1;
+  }
+}
+
+Bitmap NetpbmImage::ToBitmap() const {
+  Bitmap bitmap(size_x_, size_y_);
+  for (int y = 0; y < size_y_; ++y) {
+    PackRow(y, bitmap.Row(y));
+  }
+  return bitmap;
+}
+
+std::list<Segment> ExtractPrimitives(const NetpbmImage& image,
+                                     const ExtractParams& params) {
+  auto bitmap = Binarize(image);
+  return BaseExtractPrimitives(bitmap, params);
+}
+
+}  // namespace PTIT
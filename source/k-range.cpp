@@ -0,0 +1,56 @@
+#include "k-range.hpp"
+
+namespace PTIT {
+
+DegKRange DegKRange::FromSegment(const Segment& segment) {
+  if (segment.GetA() == segment.GetB()) {
+    return DegKRange();
+  }
+  double min_angle = TanToDeg(GetKCoefficient(segment));
+  double max_angle = min_angle;
+
+  for (const auto& offset : kNeighbourOffsets) {
+    double segm_angle = TanToDeg(GetKCoefficient(
+        {segment.GetA(),
+         {segment.GetB().x + offset.x, segment.GetB().y + offset.y}}));
+    min_angle = std::min(min_angle, segm_angle);
+    max_angle = std::max(max_angle, segm_angle);
+  }
+  return DegKRange(min_angle, max_angle);
+}
+
+bool DegKRange::InRange(const Segment& segment) const {
+  if (is_empty_) {
+    return false;
+  }
+  auto deg = TanToDeg(GetKCoefficient(segment));
+
+  return AreIntersect(*this,
+                      DegKRange(deg - kDegAccuracy, deg + kDegAccuracy));
+}
+
+void DegKRange::Intersect(const DegKRange& k_range) {
+  if (is_empty_ || k_range.is_empty_) {
+    is_empty_ = true;
+    return;
+  }
+
+  min_angle_ = std::max(min_angle_, k_range.min_angle_);
+  max_angle_ = std::min(max_angle_, k_range.max_angle_);
+
+  if (min_angle_ > max_angle_) {
+    is_empty_ = true;
+  }
+}
+
+bool DegKRange::AreIntersect(DegKRange first, DegKRange second) {
+  if (first.min_angle_ == second.min_angle_) {
+    return true;
+  }
+  if (first.min_angle_ > second.min_angle_) {
+    std::swap(first, second);
+  }
+  return first.max_angle_ >= second.min_angle_;
+}
+
+}  // namespace PTIT
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "primitives.hpp"
+#include "supply.hpp"
+
+namespace PTIT {
+
+// Range of line slopes a segment may have to be continued. Both
+// implementations order slopes as atan(k) does, the vertical being the
+// greatest one.
+
+// reference implementation working with angles in degrees
+class DegKRange {
+ public:
+  DegKRange(bool empty = false) : is_empty_(empty){};
+  DegKRange(double min_angle, double max_angle)
+      : min_angle_(min_angle), max_angle_(max_angle) {
+    if (max_angle_ < min_angle_) {
+      std::swap(min_angle_, max_angle_);
+    }
+  }
+
+  static DegKRange FromSegment(const Segment& segment);
+
+  bool InRange(const Segment& segment) const;
+  void Intersect(const DegKRange& k_range);
+
+ private:
+  static constexpr double kDegAccuracy = 0.001;
+
+  bool is_empty_ = false;
+  double min_angle_ = -kDegInCircle / 4;
+  double max_angle_ = kDegInCircle / 4;
+
+  static bool AreIntersect(DegKRange first, DegKRange second);
+};
+
+// exact integer implementation: the range is a cone between two direction
+// vectors which are compared by their cross product
+class ConeKRange {
+ public:
+  ConeKRange(bool empty = false) : is_empty_(empty){};
+
+  static ConeKRange FromSegment(const Segment& segment) {
+    if (segment.GetA() == segment.GetB()) {
+      return ConeKRange();
+    }
+    auto direction = GetDirection(segment.GetA(), segment.GetB());
+    ConeKRange k_range(direction, direction);
+
+    for (const auto& offset : kNeighbourOffsets) {
+      direction =
+          GetDirection(segment.GetA(), {segment.GetB().x + offset.x,
+                                        segment.GetB().y + offset.y});
+      if (IsLess(direction, k_range.min_dir_)) {
+        k_range.min_dir_ = direction;
+      } else if (IsLess(k_range.max_dir_, direction)) {
+        k_range.max_dir_ = direction;
+      }
+    }
+    return k_range;
+  }
+
+  bool InRange(const Segment& segment) const {
+    if (is_empty_) {
+      return false;
+    }
+    auto direction = GetDirection(segment.GetA(), segment.GetB());
+    return !IsLess(direction, min_dir_) && !IsLess(max_dir_, direction);
+  }
+  void Intersect(const ConeKRange& k_range) {
+    if (is_empty_ || k_range.is_empty_) {
+      is_empty_ = true;
+      return;
+    }
+
+    if (IsLess(min_dir_, k_range.min_dir_)) {
+      min_dir_ = k_range.min_dir_;
+    }
+    if (IsLess(k_range.max_dir_, max_dir_)) {
+      max_dir_ = k_range.max_dir_;
+    }
+
+    if (IsLess(max_dir_, min_dir_)) {
+      is_empty_ = true;
+    }
+  }
+
+ private:
+  // direction with non-negative x, a vertical one is {0, 1} unless it stands
+  // for the lowest bound, {0, -1}
+  struct Direction {
+    int64_t x;
+    int64_t y;
+  };
+
+  bool is_empty_ = false;
+  Direction min_dir_ = {0, -1};
+  Direction max_dir_ = {0, 1};
+
+  ConeKRange(const Direction& min_dir, const Direction& max_dir)
+      : min_dir_(min_dir), max_dir_(max_dir) {}
+
+  static Direction GetDirection(const Coord& from, const Coord& to) {
+    int64_t d_x = static_cast<int64_t>(to.x) - from.x;
+    int64_t d_y = static_cast<int64_t>(to.y) - from.y;
+    if (d_x == 0) {
+      return {0, 1};
+    }
+    return d_x > 0 ? Direction{d_x, d_y} : Direction{-d_x, -d_y};
+  }
+  static bool IsLess(const Direction& first, const Direction& second) {
+    if (first.x == 0 || second.x == 0) {
+      if (first.x == 0 && second.x == 0) {
+        return first.y < second.y;
+      }
+      return first.x == 0 ? first.y < 0 : second.y > 0;
+    }
+    return first.y * second.x < second.y * first.x;
+  }
+};
+
+}  // namespace PTIT
@@ -0,0 +1,429 @@
+#include "primitive-batch.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <float.h>
+#include <limits.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace PTIT {
+
+void SegmentBatch::Add(const Segment& segment) {
+  a_x.push_back(segment.GetA().x);
+  a_y.push_back(segment.GetA().y);
+  b_x.push_back(segment.GetB().x);
+  b_y.push_back(segment.GetB().y);
+}
+
+Segment SegmentBatch::Get(size_t index) const {
+  return {{a_x[index], a_y[index]}, {b_x[index], b_y[index]}};
+}
+
+void SegmentBatch::Set(size_t index, const Segment& segment) {
+  a_x[index] = segment.GetA().x;
+  a_y[index] = segment.GetA().y;
+  b_x[index] = segment.GetB().x;
+  b_y[index] = segment.GetB().y;
+}
+
+std::list<Segment> SegmentBatch::ToList() const {
+  std::list<Segment> segments;
+  for (size_t index = 0; index < Size(); ++index) {
+    segments.push_back(Get(index));
+  }
+  return segments;
+}
+
+void TriangleBatch::Add(const Triangle& triangle) {
+  auto [a_point, b_point, c_point] = triangle.GetPoints();
+  a_x.push_back(a_point.x);
+  a_y.push_back(a_point.y);
+  b_x.push_back(b_point.x);
+  b_y.push_back(b_point.y);
+  c_x.push_back(c_point.x);
+  c_y.push_back(c_point.y);
+}
+
+Triangle TriangleBatch::Get(size_t index) const {
+  return {{a_x[index], a_y[index]},
+          {b_x[index], b_y[index]},
+          {c_x[index], c_y[index]}};
+}
+
+void CirceBatch::Add(const Circe& circe) {
+  center_x.push_back(circe.GetCenter().x);
+  center_y.push_back(circe.GetCenter().y);
+  radius.push_back(circe.GetRadius());
+}
+
+Circe CirceBatch::Get(size_t index) const {
+  return {{center_x[index], center_y[index]},
+          static_cast<double>(radius[index])};
+}
+
+#ifdef __SSE2__
+__m128i LoadPair(const int* data) {
+  return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+}
+
+void StorePair(int* data, __m128i values) {
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(data), values);
+}
+
+// first where the mask is set, second elsewhere
+__m128i SelectEpi32(__m128i mask, __m128i first, __m128i second) {
+  return _mm_or_si128(_mm_and_si128(mask, first),
+                      _mm_andnot_si128(mask, second));
+}
+
+// halves rounded toward zero, as int division does
+__m128i HalveEpi32(__m128i values) {
+  return _mm_srai_epi32(_mm_add_epi32(values, _mm_srli_epi32(values, 31)), 1);
+}
+
+__m128d Hypot(__m128d dx, __m128d dy) {
+  return _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+}
+#endif
+
+// int *= float: the product in float, truncated
+void ScaleCoords(std::vector<int>& coords, float coef) {
+  int* data = coords.data();
+  size_t index = 0;
+#ifdef __SSE2__
+  __m128 factor = _mm_set1_ps(coef);
+  for (; index + 4 <= coords.size(); index += 4) {
+    auto* pos = reinterpret_cast<__m128i*>(data + index);
+    __m128 values = _mm_cvtepi32_ps(_mm_loadu_si128(pos));
+    _mm_storeu_si128(pos, _mm_cvttps_epi32(_mm_mul_ps(values, factor)));
+  }
+#endif
+  for (; index < coords.size(); ++index) {
+    data[index] *= coef;
+  }
+}
+
+void TranslateCoords(std::vector<int>& coords, int offset) {
+  int* data = coords.data();
+  size_t index = 0;
+#ifdef __SSE2__
+  __m128i shift = _mm_set1_epi32(offset);
+  for (; index + 4 <= coords.size(); index += 4) {
+    auto* pos = reinterpret_cast<__m128i*>(data + index);
+    _mm_storeu_si128(pos, _mm_add_epi32(_mm_loadu_si128(pos), shift));
+  }
+#endif
+  for (; index < coords.size(); ++index) {
+    data[index] += offset;
+  }
+}
+
+void RotatePoints(std::vector<int>& xs, std::vector<int>& ys,
+                  const Coord& center, double cos_n, double sin_n) {
+  size_t index = 0;
+#ifdef __SSE2__
+  __m128d center_x = _mm_set1_pd(center.x);
+  __m128d center_y = _mm_set1_pd(center.y);
+  __m128d cos_v = _mm_set1_pd(cos_n);
+  __m128d sin_v = _mm_set1_pd(sin_n);
+  for (; index + 2 <= xs.size(); index += 2) {
+    __m128d dx =
+        _mm_sub_pd(_mm_cvtepi32_pd(LoadPair(xs.data() + index)), center_x);
+    __m128d dy =
+        _mm_sub_pd(_mm_cvtepi32_pd(LoadPair(ys.data() + index)), center_y);
+    __m128d x = _mm_add_pd(
+        center_x, _mm_sub_pd(_mm_mul_pd(dx, cos_v), _mm_mul_pd(dy, sin_v)));
+    __m128d y = _mm_add_pd(
+        center_y, _mm_add_pd(_mm_mul_pd(dx, sin_v), _mm_mul_pd(dy, cos_v)));
+    // rounded to the nearest under the default rounding mode
+    StorePair(xs.data() + index, _mm_cvtpd_epi32(x));
+    StorePair(ys.data() + index, _mm_cvtpd_epi32(y));
+  }
+#endif
+  for (; index < xs.size(); ++index) {
+    double dx = static_cast<double>(xs[index]) - center.x;
+    double dy = static_cast<double>(ys[index]) - center.y;
+    xs[index] = static_cast<int>(
+        std::nearbyint(center.x + (dx * cos_n - dy * sin_n)));
+    ys[index] = static_cast<int>(
+        std::nearbyint(center.y + (dx * sin_n + dy * cos_n)));
+  }
+}
+
+// widens [low, high] to the coordinates, less and plus the radii when there
+// are some
+void WidenRange(const std::vector<int>& coords, const std::vector<int>* radii,
+                int& low, int& high) {
+  size_t index = 0;
+#ifdef __SSE2__
+  if (coords.size() >= 4) {
+    __m128i lows = _mm_set1_epi32(low);
+    __m128i highs = _mm_set1_epi32(high);
+    for (; index + 4 <= coords.size(); index += 4) {
+      __m128i values = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(coords.data() + index));
+      __m128i firsts = values;
+      __m128i lasts = values;
+      if (radii != nullptr) {
+        __m128i extents = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(radii->data() + index));
+        __m128i sign = _mm_srai_epi32(extents, 31);
+        extents = _mm_sub_epi32(_mm_xor_si128(extents, sign), sign);
+        firsts = _mm_sub_epi32(values, extents);
+        lasts = _mm_add_epi32(values, extents);
+      }
+      lows = SelectEpi32(_mm_cmpgt_epi32(lows, firsts), firsts, lows);
+      highs = SelectEpi32(_mm_cmpgt_epi32(lasts, highs), lasts, highs);
+    }
+
+    int lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), lows);
+    low = *std::min_element(lanes, lanes + 4);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), highs);
+    high = *std::max_element(lanes, lanes + 4);
+  }
+#endif
+  for (; index < coords.size(); ++index) {
+    int extent = radii != nullptr ? std::abs((*radii)[index]) : 0;
+    low = std::min(low, coords[index] - extent);
+    high = std::max(high, coords[index] + extent);
+  }
+}
+
+// the ranges of the x and y coordinates, end excluded but saturated
+Rect RangesBounds(int low_x, int high_x, int low_y, int high_y) {
+  return {{low_x, low_y},
+          {high_x + (high_x < INT_MAX), high_y + (high_y < INT_MAX)}};
+}
+
+void Scale(SegmentBatch& batch, float coef) {
+  for (auto* coords : {&batch.a_x, &batch.a_y, &batch.b_x, &batch.b_y}) {
+    ScaleCoords(*coords, coef);
+  }
+}
+
+void Scale(TriangleBatch& batch, float coef) {
+  for (auto* coords : {&batch.a_x, &batch.a_y, &batch.b_x, &batch.b_y,
+                       &batch.c_x, &batch.c_y}) {
+    ScaleCoords(*coords, coef);
+  }
+}
+
+void Scale(CirceBatch& batch, float coef) {
+  for (auto* coords : {&batch.center_x, &batch.center_y, &batch.radius}) {
+    ScaleCoords(*coords, coef);
+  }
+}
+
+void Translate(SegmentBatch& batch, const Coord& offset) {
+  TranslateCoords(batch.a_x, offset.x);
+  TranslateCoords(batch.a_y, offset.y);
+  TranslateCoords(batch.b_x, offset.x);
+  TranslateCoords(batch.b_y, offset.y);
+}
+
+void Translate(TriangleBatch& batch, const Coord& offset) {
+  TranslateCoords(batch.a_x, offset.x);
+  TranslateCoords(batch.a_y, offset.y);
+  TranslateCoords(batch.b_x, offset.x);
+  TranslateCoords(batch.b_y, offset.y);
+  TranslateCoords(batch.c_x, offset.x);
+  TranslateCoords(batch.c_y, offset.y);
+}
+
+void Translate(CirceBatch& batch, const Coord& offset) {
+  TranslateCoords(batch.center_x, offset.x);
+  TranslateCoords(batch.center_y, offset.y);
+}
+
+void Rotate(SegmentBatch& batch, const Coord& center, double deg) {
+  double rad = DegToRad(deg);
+  RotatePoints(batch.a_x, batch.a_y, center, std::cos(rad), std::sin(rad));
+  RotatePoints(batch.b_x, batch.b_y, center, std::cos(rad), std::sin(rad));
+}
+
+void Rotate(TriangleBatch& batch, const Coord& center, double deg) {
+  double rad = DegToRad(deg);
+  RotatePoints(batch.a_x, batch.a_y, center, std::cos(rad), std::sin(rad));
+  RotatePoints(batch.b_x, batch.b_y, center, std::cos(rad), std::sin(rad));
+  RotatePoints(batch.c_x, batch.c_y, center, std::cos(rad), std::sin(rad));
+}
+
+void Rotate(CirceBatch& batch, const Coord& center, double deg) {
+  double rad = DegToRad(deg);
+  RotatePoints(batch.center_x, batch.center_y, center, std::cos(rad),
+               std::sin(rad));
+}
+
+Rect GetBounds(const SegmentBatch& batch) {
+  if (batch.Size() == 0) {
+    return {{0, 0}, {0, 0}};
+  }
+  int low_x = INT_MAX;
+  int high_x = INT_MIN;
+  int low_y = INT_MAX;
+  int high_y = INT_MIN;
+  for (const auto* coords : {&batch.a_x, &batch.b_x}) {
+    WidenRange(*coords, nullptr, low_x, high_x);
+  }
+  for (const auto* coords : {&batch.a_y, &batch.b_y}) {
+    WidenRange(*coords, nullptr, low_y, high_y);
+  }
+  return RangesBounds(low_x, high_x, low_y, high_y);
+}
+
+Rect GetBounds(const TriangleBatch& batch) {
+  if (batch.Size() == 0) {
+    return {{0, 0}, {0, 0}};
+  }
+  int low_x = INT_MAX;
+  int high_x = INT_MIN;
+  int low_y = INT_MAX;
+  int high_y = INT_MIN;
+  for (const auto* coords : {&batch.a_x, &batch.b_x, &batch.c_x}) {
+    WidenRange(*coords, nullptr, low_x, high_x);
+  }
+  for (const auto* coords : {&batch.a_y, &batch.b_y, &batch.c_y}) {
+    WidenRange(*coords, nullptr, low_y, high_y);
+  }
+  return RangesBounds(low_x, high_x, low_y, high_y);
+}
+
+Rect GetBounds(const CirceBatch& batch) {
+  if (batch.Size() == 0) {
+    return {{0, 0}, {0, 0}};
+  }
+  int low_x = INT_MAX;
+  int high_x = INT_MIN;
+  int low_y = INT_MAX;
+  int high_y = INT_MIN;
+  WidenRange(batch.center_x, &batch.radius, low_x, high_x);
+  WidenRange(batch.center_y, &batch.radius, low_y, high_y);
+  return RangesBounds(low_x, high_x, low_y, high_y);
+}
+
+void GetLengths(const SegmentBatch& batch, std::vector<double>& lengths) {
+  lengths.resize(batch.Size());
+  size_t index = 0;
+#ifdef __SSE2__
+  for (; index + 2 <= batch.Size(); index += 2) {
+    __m128d dx =
+        _mm_cvtepi32_pd(_mm_sub_epi32(LoadPair(batch.b_x.data() + index),
+                                      LoadPair(batch.a_x.data() + index)));
+    __m128d dy =
+        _mm_cvtepi32_pd(_mm_sub_epi32(LoadPair(batch.b_y.data() + index),
+                                      LoadPair(batch.a_y.data() + index)));
+    _mm_storeu_pd(lengths.data() + index, Hypot(dx, dy));
+  }
+#endif
+  for (; index < batch.Size(); ++index) {
+    auto segment = batch.Get(index);
+    lengths[index] = GetDistance(segment.GetA(), segment.GetB());
+  }
+}
+
+void GetAngles(const SegmentBatch& batch, std::vector<double>& angles) {
+  angles.resize(batch.Size());
+  for (size_t index = 0; index < batch.Size(); ++index) {
+    angles[index] = batch.Get(index).GetAngle();
+  }
+}
+
+void SetLen(SegmentBatch& batch, int len) {
+  size_t index = 0;
+#ifdef __SSE2__
+  __m128d length = _mm_set1_pd(len);
+  __m128i half = _mm_set1_epi32(len / 2);
+  __m128i rest = _mm_set1_epi32(len % 2);
+  for (; index + 2 <= batch.Size(); index += 2) {
+    __m128i a_x = LoadPair(batch.a_x.data() + index);
+    __m128i a_y = LoadPair(batch.a_y.data() + index);
+    __m128i b_x = LoadPair(batch.b_x.data() + index);
+    __m128i b_y = LoadPair(batch.b_y.data() + index);
+    __m128i center_x = HalveEpi32(_mm_add_epi32(a_x, b_x));
+    __m128i center_y = HalveEpi32(_mm_add_epi32(a_y, b_y));
+    __m128d center_x_d = _mm_cvtepi32_pd(center_x);
+    __m128d center_y_d = _mm_cvtepi32_pd(center_y);
+
+    // ends moved along the segment to len from the center
+    __m128d a_dx = _mm_cvtepi32_pd(_mm_sub_epi32(a_x, center_x));
+    __m128d a_dy = _mm_cvtepi32_pd(_mm_sub_epi32(a_y, center_y));
+    __m128d b_dx = _mm_cvtepi32_pd(_mm_sub_epi32(b_x, center_x));
+    __m128d b_dy = _mm_cvtepi32_pd(_mm_sub_epi32(b_y, center_y));
+    __m128d a_ratio = _mm_div_pd(length, Hypot(a_dx, a_dy));
+    __m128d b_ratio = _mm_div_pd(length, Hypot(b_dx, b_dy));
+    auto moved = [](__m128d ratio, __m128d delta, __m128d center) {
+      return _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(ratio, delta), center));
+    };
+
+    // vertical segments get len around the center
+    __m128i vertical = _mm_cmpeq_epi32(a_x, b_x);
+    StorePair(batch.a_x.data() + index,
+              SelectEpi32(vertical, a_x, moved(a_ratio, a_dx, center_x_d)));
+    StorePair(batch.a_y.data() + index,
+              SelectEpi32(vertical, _mm_sub_epi32(center_y, half),
+                          moved(a_ratio, a_dy, center_y_d)));
+    StorePair(batch.b_x.data() + index,
+              SelectEpi32(vertical, b_x, moved(b_ratio, b_dx, center_x_d)));
+    StorePair(batch.b_y.data() + index,
+              SelectEpi32(vertical,
+                          _mm_add_epi32(_mm_add_epi32(center_y, half), rest),
+                          moved(b_ratio, b_dy, center_y_d)));
+  }
+#endif
+  for (; index < batch.Size(); ++index) {
+    auto segment = batch.Get(index);
+    segment.SetLen(len);
+    batch.Set(index, segment);
+  }
+}
+
+void SetAngle(SegmentBatch& batch, double deg) {
+  size_t index = 0;
+#ifdef __SSE2__
+  // the direction Segment::SetAngle gives, once for all the segments
+  double k_coef = tan(DegToRad(deg));
+  double sin_n = 1;
+  double cos_n = 0;
+  if (k_coef != FLT_MAX) {
+    double denominator = sqrt(1 + (k_coef * k_coef));
+    sin_n = k_coef / denominator;
+    cos_n = 1 / denominator;
+  }
+
+  __m128d sin_v = _mm_set1_pd(sin_n);
+  __m128d cos_v = _mm_set1_pd(cos_n);
+  __m128d two = _mm_set1_pd(2);
+  for (; index + 2 <= batch.Size(); index += 2) {
+    __m128i a_x = LoadPair(batch.a_x.data() + index);
+    __m128i a_y = LoadPair(batch.a_y.data() + index);
+    __m128i b_x = LoadPair(batch.b_x.data() + index);
+    __m128i b_y = LoadPair(batch.b_y.data() + index);
+    __m128i center_x = HalveEpi32(_mm_add_epi32(a_x, b_x));
+    __m128i center_y = HalveEpi32(_mm_add_epi32(a_y, b_y));
+
+    __m128d half_len =
+        _mm_div_pd(Hypot(_mm_cvtepi32_pd(_mm_sub_epi32(b_x, a_x)),
+                         _mm_cvtepi32_pd(_mm_sub_epi32(b_y, a_y))),
+                   two);
+    __m128i delta_x = _mm_cvttpd_epi32(_mm_mul_pd(half_len, cos_v));
+    __m128i delta_y = _mm_cvttpd_epi32(_mm_mul_pd(half_len, sin_v));
+
+    StorePair(batch.a_x.data() + index, _mm_sub_epi32(center_x, delta_x));
+    StorePair(batch.a_y.data() + index, _mm_sub_epi32(center_y, delta_y));
+    StorePair(batch.b_x.data() + index, _mm_add_epi32(center_x, delta_x));
+    StorePair(batch.b_y.data() + index, _mm_add_epi32(center_y, delta_y));
+  }
+#endif
+  for (; index < batch.Size(); ++index) {
+    auto segment = batch.Get(index);
+    segment.SetAngle(deg);
+    batch.Set(index, segment);
+  }
+}
+
+}  // namespace PTIT
@@ -0,0 +1,431 @@
+#include "primitive-file.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+
+namespace PTIT {
+
+const char kPrimitiveFileMagic[8] = {'P', 'T', 'I', 'T', 'P', 'R', 'I', 'M'};
+const char kPrimitiveTrailerMagic[4] = {'P', 'E', 'N', 'D'};
+const uint32_t kPrimitiveFileVersion = 1;
+const size_t kPrimitiveHeaderSize = 16;
+const size_t kPrimitiveIndexEntrySize = 40;
+const size_t kPrimitiveTrailerSize = 16;
+
+template <typename Value>
+void PutLittleEndian(Value value, std::vector<char>& buffer) {
+  for (size_t byte = 0; byte < sizeof(Value); ++byte) {
+    buffer.push_back(
+        static_cast<char>(static_cast<uint64_t>(value) >> (8 * byte)));
+  }
+}
+
+template <typename Value>
+Value GetLittleEndian(const uint8_t* pos) {
+  uint64_t value = 0;
+  for (size_t byte = 0; byte < sizeof(Value); ++byte) {
+    value |= static_cast<uint64_t>(pos[byte]) << (8 * byte);
+  }
+  return static_cast<Value>(value);
+}
+
+// zigzag, so that small negative differences take a byte too, then 7 bits a
+// byte, lowest first
+void PutVarint(int64_t value, std::vector<char>& buffer) {
+  auto zigzag = (static_cast<uint64_t>(value) << 1) ^
+                static_cast<uint64_t>(value >> 63);
+  while (zigzag >= 0x80) {
+    buffer.push_back(static_cast<char>(zigzag | 0x80));
+    zigzag >>= 7;
+  }
+  buffer.push_back(static_cast<char>(zigzag));
+}
+
+int64_t GetVarint(const uint8_t*& pos, const uint8_t* end) {
+  uint64_t zigzag = 0;
+  for (int shift = 0;; shift += 7) {
+    if (pos == end || shift > 63) {
+      throw std::runtime_error("Corrupted primitives file");
+    }
+    uint8_t byte = *pos++;
+    zigzag |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  return static_cast<int64_t>(zigzag >> 1) ^
+         -static_cast<int64_t>(zigzag & 1);
+}
+
+void PutPoint(const Coord& point, const Coord& origin,
+              std::vector<char>& buffer) {
+  PutVarint(static_cast<int64_t>(point.x) - origin.x, buffer);
+  PutVarint(static_cast<int64_t>(point.y) - origin.y, buffer);
+}
+
+Coord GetPoint(const uint8_t*& pos, const uint8_t* end, const Coord& origin) {
+  auto x = static_cast<int>(origin.x + GetVarint(pos, end));
+  auto y = static_cast<int>(origin.y + GetVarint(pos, end));
+  return {x, y};
+}
+
+uint64_t SpreadBits(uint32_t value) {
+  uint64_t spread = value;
+  spread = (spread | spread << 16) & 0x0000FFFF0000FFFF;
+  spread = (spread | spread << 8) & 0x00FF00FF00FF00FF;
+  spread = (spread | spread << 4) & 0x0F0F0F0F0F0F0F0F;
+  spread = (spread | spread << 2) & 0x3333333333333333;
+  spread = (spread | spread << 1) & 0x5555555555555555;
+  return spread;
+}
+
+// position on a Z-order curve, negative coordinates first
+uint64_t ZOrder(const Coord& point) {
+  return SpreadBits(static_cast<uint32_t>(point.x) ^ 0x80000000) |
+         SpreadBits(static_cast<uint32_t>(point.y) ^ 0x80000000) << 1;
+}
+
+Rect PointsBounds(std::initializer_list<Coord> points) {
+  Rect bounds = {*points.begin(), *points.begin()};
+  for (const auto& point : points) {
+    bounds.begin.x = std::min(bounds.begin.x, point.x);
+    bounds.begin.y = std::min(bounds.begin.y, point.y);
+    bounds.end.x = std::max(bounds.end.x, point.x);
+    bounds.end.y = std::max(bounds.end.y, point.y);
+  }
+  // saturated, points at the largest coordinate are left out of queries
+  bounds.end.x += bounds.end.x < std::numeric_limits<int>::max();
+  bounds.end.y += bounds.end.y < std::numeric_limits<int>::max();
+  return bounds;
+}
+
+int ClampCoord(int64_t value) {
+  return static_cast<int>(
+      std::clamp<int64_t>(value, std::numeric_limits<int>::min(),
+                          std::numeric_limits<int>::max()));
+}
+
+void UniteBounds(Rect& bounds, const Rect& other) {
+  bounds.begin.x = std::min(bounds.begin.x, other.begin.x);
+  bounds.begin.y = std::min(bounds.begin.y, other.begin.y);
+  bounds.end.x = std::max(bounds.end.x, other.end.x);
+  bounds.end.y = std::max(bounds.end.y, other.end.y);
+}
+
+bool BoundsMeet(const Rect& first, const Rect& second) {
+  return first.begin.x < second.end.x && second.begin.x < first.end.x &&
+         first.begin.y < second.end.y && second.begin.y < first.end.y;
+}
+
+template <typename Primitive>
+struct PrimitiveCodec;
+
+template <>
+struct PrimitiveCodec<Segment> {
+  static constexpr PrimitiveKind kKind = PrimitiveKind::kSegment;
+
+  static Coord First(const Segment& segment) { return segment.GetA(); }
+  static Rect Bounds(const Segment& segment) {
+    return PointsBounds({segment.GetA(), segment.GetB()});
+  }
+
+  static void Encode(const Segment& segment, const Coord& previous,
+                     std::vector<char>& buffer) {
+    PutPoint(segment.GetA(), previous, buffer);
+    PutPoint(segment.GetB(), segment.GetA(), buffer);
+  }
+  static Segment Decode(const uint8_t*& pos, const uint8_t* end,
+                        const Coord& previous) {
+    auto a_point = GetPoint(pos, end, previous);
+    return {a_point, GetPoint(pos, end, a_point)};
+  }
+};
+
+template <>
+struct PrimitiveCodec<Triangle> {
+  static constexpr PrimitiveKind kKind = PrimitiveKind::kTriangle;
+
+  static Coord First(const Triangle& triangle) {
+    return std::get<0>(triangle.GetPoints());
+  }
+  static Rect Bounds(const Triangle& triangle) {
+    auto [a_point, b_point, c_point] = triangle.GetPoints();
+    return PointsBounds({a_point, b_point, c_point});
+  }
+
+  static void Encode(const Triangle& triangle, const Coord& previous,
+                     std::vector<char>& buffer) {
+    auto [a_point, b_point, c_point] = triangle.GetPoints();
+    PutPoint(a_point, previous, buffer);
+    PutPoint(b_point, a_point, buffer);
+    PutPoint(c_point, a_point, buffer);
+  }
+  static Triangle Decode(const uint8_t*& pos, const uint8_t* end,
+                         const Coord& previous) {
+    auto a_point = GetPoint(pos, end, previous);
+    auto b_point = GetPoint(pos, end, a_point);
+    return {a_point, b_point, GetPoint(pos, end, a_point)};
+  }
+};
+
+template <>
+struct PrimitiveCodec<Circe> {
+  static constexpr PrimitiveKind kKind = PrimitiveKind::kCirce;
+
+  static Coord First(const Circe& circe) { return circe.GetCenter(); }
+  static Rect Bounds(const Circe& circe) {
+    const auto& center = circe.GetCenter();
+    int64_t radius = std::abs(static_cast<int64_t>(circe.GetRadius()));
+    return PointsBounds({{ClampCoord(center.x - radius),
+                          ClampCoord(center.y - radius)},
+                         {ClampCoord(center.x + radius),
+                          ClampCoord(center.y + radius)}});
+  }
+
+  static void Encode(const Circe& circe, const Coord& previous,
+                     std::vector<char>& buffer) {
+    PutPoint(circe.GetCenter(), previous, buffer);
+    PutVarint(circe.GetRadius(), buffer);
+  }
+  static Circe Decode(const uint8_t*& pos, const uint8_t* end,
+                      const Coord& previous) {
+    auto center = GetPoint(pos, end, previous);
+    return {center, static_cast<double>(GetVarint(pos, end))};
+  }
+};
+
+PrimitiveWriter::PrimitiveWriter(const char* file, int block_size)
+    : file_(file, std::ios::binary),
+      block_size_(static_cast<size_t>(std::max(block_size, 1))) {
+  if (!file_.is_open()) {
+    throw std::runtime_error("Cannot open file");
+  }
+  file_.write(kPrimitiveFileMagic, sizeof(kPrimitiveFileMagic));
+  PutLittleEndian(kPrimitiveFileVersion, buffer_);
+  PutLittleEndian(uint32_t(0), buffer_);
+  file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  offset_ = sizeof(kPrimitiveFileMagic) + buffer_.size();
+  buffer_.clear();
+}
+
+PrimitiveWriter::~PrimitiveWriter() {
+  if (file_.is_open()) {
+    Finish();
+  }
+}
+
+void PrimitiveWriter::Add(const Segment& segment) {
+  segments_.push_back(segment);
+  if (segments_.size() == block_size_) {
+    WriteBlock(segments_);
+  }
+}
+
+void PrimitiveWriter::Add(const Triangle& triangle) {
+  triangles_.push_back(triangle);
+  if (triangles_.size() == block_size_) {
+    WriteBlock(triangles_);
+  }
+}
+
+void PrimitiveWriter::Add(const Circe& circe) {
+  circes_.push_back(circe);
+  if (circes_.size() == block_size_) {
+    WriteBlock(circes_);
+  }
+}
+
+void PrimitiveWriter::Close() {
+  if (!file_.is_open()) {
+    return;
+  }
+  Finish();
+  file_.close();
+  if (file_.fail()) {
+    throw std::runtime_error("Cannot write file");
+  }
+}
+
+template <typename Primitive>
+void PrimitiveWriter::WriteBlock(std::vector<Primitive>& primitives) {
+  using Codec = PrimitiveCodec<Primitive>;
+  if (primitives.empty()) {
+    return;
+  }
+
+  std::stable_sort(primitives.begin(), primitives.end(),
+                   [](const Primitive& first, const Primitive& second) {
+                     return ZOrder(Codec::First(first)) <
+                            ZOrder(Codec::First(second));
+                   });
+
+  PrimitiveBlock block = {Codec::kKind,
+                          static_cast<uint32_t>(primitives.size()), offset_,
+                          0, Codec::Bounds(primitives.front())};
+  Coord previous = {0, 0};
+  for (const auto& primitive : primitives) {
+    Codec::Encode(primitive, previous, buffer_);
+    previous = Codec::First(primitive);
+    UniteBounds(block.bounds, Codec::Bounds(primitive));
+  }
+  block.size = buffer_.size();
+
+  file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  offset_ += buffer_.size();
+  buffer_.clear();
+  blocks_.push_back(block);
+  primitives.clear();
+}
+
+void PrimitiveWriter::Finish() {
+  WriteBlock(segments_);
+  WriteBlock(triangles_);
+  WriteBlock(circes_);
+
+  for (const auto& block : blocks_) {
+    PutLittleEndian(static_cast<uint32_t>(block.kind), buffer_);
+    PutLittleEndian(block.count, buffer_);
+    PutLittleEndian(block.offset, buffer_);
+    PutLittleEndian(block.size, buffer_);
+    PutLittleEndian(block.bounds.begin.x, buffer_);
+    PutLittleEndian(block.bounds.begin.y, buffer_);
+    PutLittleEndian(block.bounds.end.x, buffer_);
+    PutLittleEndian(block.bounds.end.y, buffer_);
+  }
+  PutLittleEndian(offset_, buffer_);
+  PutLittleEndian(static_cast<uint32_t>(blocks_.size()), buffer_);
+  buffer_.insert(buffer_.end(), kPrimitiveTrailerMagic,
+                 kPrimitiveTrailerMagic + sizeof(kPrimitiveTrailerMagic));
+  file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  buffer_.clear();
+}
+
+PrimitiveReader::PrimitiveReader(const char* file) : file_(file) {
+  const uint8_t* data = file_.Data();
+  size_t size = file_.Size();
+  if (size < kPrimitiveHeaderSize + kPrimitiveTrailerSize ||
+      std::memcmp(data, kPrimitiveFileMagic, sizeof(kPrimitiveFileMagic)) !=
+          0) {
+    throw std::runtime_error("Not a primitives file");
+  }
+  if (GetLittleEndian<uint32_t>(data + 8) != kPrimitiveFileVersion) {
+    throw std::runtime_error("Unsupported primitives file version");
+  }
+
+  const uint8_t* trailer = data + size - kPrimitiveTrailerSize;
+  auto index_offset = GetLittleEndian<uint64_t>(trailer);
+  auto blocks_num = GetLittleEndian<uint32_t>(trailer + 8);
+  if (std::memcmp(trailer + 12, kPrimitiveTrailerMagic,
+                  sizeof(kPrimitiveTrailerMagic)) != 0 ||
+      index_offset < kPrimitiveHeaderSize ||
+      index_offset > size - kPrimitiveTrailerSize ||
+      size - kPrimitiveTrailerSize - index_offset !=
+          uint64_t(blocks_num) * kPrimitiveIndexEntrySize) {
+    throw std::runtime_error("Corrupted primitives file");
+  }
+
+  for (const uint8_t* entry = data + index_offset; entry != trailer;
+       entry += kPrimitiveIndexEntrySize) {
+    PrimitiveBlock block = {
+        static_cast<PrimitiveKind>(GetLittleEndian<uint32_t>(entry)),
+        GetLittleEndian<uint32_t>(entry + 4),
+        GetLittleEndian<uint64_t>(entry + 8),
+        GetLittleEndian<uint64_t>(entry + 16),
+        {{GetLittleEndian<int32_t>(entry + 24),
+          GetLittleEndian<int32_t>(entry + 28)},
+         {GetLittleEndian<int32_t>(entry + 32),
+          GetLittleEndian<int32_t>(entry + 36)}}};
+    if (block.kind > PrimitiveKind::kCirce ||
+        block.offset < kPrimitiveHeaderSize || block.offset > index_offset ||
+        block.size > index_offset - block.offset) {
+      throw std::runtime_error("Corrupted primitives file");
+    }
+    blocks_.push_back(block);
+  }
+}
+
+Rect PrimitiveReader::Bounds() const {
+  if (blocks_.empty()) {
+    return {{0, 0}, {0, 0}};
+  }
+  auto bounds = blocks_.front().bounds;
+  for (const auto& block : blocks_) {
+    UniteBounds(bounds, block.bounds);
+  }
+  return bounds;
+}
+
+template <typename Primitive>
+void PrimitiveReader::Decode(size_t index, const Rect* area,
+                             std::vector<Primitive>& primitives) const {
+  using Codec = PrimitiveCodec<Primitive>;
+  const auto& block = blocks_.at(index);
+  if (block.kind != Codec::kKind) {
+    throw std::runtime_error("Block of another kind");
+  }
+
+  const uint8_t* pos = file_.Data() + block.offset;
+  const uint8_t* end = pos + block.size;
+  Coord previous = {0, 0};
+  for (uint32_t count = 0; count < block.count; ++count) {
+    auto primitive = Codec::Decode(pos, end, previous);
+    previous = Codec::First(primitive);
+    if (area == nullptr || BoundsMeet(Codec::Bounds(primitive), *area)) {
+      primitives.push_back(primitive);
+    }
+  }
+  if (pos != end) {
+    throw std::runtime_error("Corrupted primitives file");
+  }
+}
+
+void PrimitiveReader::ReadBlock(size_t index,
+                                std::vector<Segment>& segments) const {
+  Decode(index, nullptr, segments);
+}
+
+void PrimitiveReader::ReadBlock(size_t index,
+                                std::vector<Triangle>& triangles) const {
+  Decode(index, nullptr, triangles);
+}
+
+void PrimitiveReader::ReadBlock(size_t index,
+                                std::vector<Circe>& circes) const {
+  Decode(index, nullptr, circes);
+}
+
+void PrimitiveReader::Query(const Rect& area,
+                            std::vector<Segment>& segments) const {
+  for (size_t index = 0; index < blocks_.size(); ++index) {
+    if (blocks_[index].kind == PrimitiveKind::kSegment &&
+        BoundsMeet(blocks_[index].bounds, area)) {
+      Decode(index, &area, segments);
+    }
+  }
+}
+
+void PrimitiveReader::Query(const Rect& area,
+                            std::vector<Triangle>& triangles) const {
+  for (size_t index = 0; index < blocks_.size(); ++index) {
+    if (blocks_[index].kind == PrimitiveKind::kTriangle &&
+        BoundsMeet(blocks_[index].bounds, area)) {
+      Decode(index, &area, triangles);
+    }
+  }
+}
+
+void PrimitiveReader::Query(const Rect& area,
+                            std::vector<Circe>& circes) const {
+  for (size_t index = 0; index < blocks_.size(); ++index) {
+    if (blocks_[index].kind == PrimitiveKind::kCirce &&
+        BoundsMeet(blocks_[index].bounds, area)) {
+      Decode(index, &area, circes);
+    }
+  }
+}
+
+}  // namespace PTIT
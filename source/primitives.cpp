@@ -1,12 +1,15 @@
 #include "primitives.hpp"
 
 #include <float.h>
+#include <limits.h>
 
 #include <algorithm>
 #include <cmath>
 #include <list>
 #include <optional>
 
+#include "raster.hpp"
+#include "stencil-cache.hpp"
 #include "supply.hpp"
 
 namespace PTIT {
@@ -86,48 +89,13 @@ void Segment::SetLen(int len) {
 void Segment::SetAngle(double deg) { SetKCoef(tan(DegToRad(deg))); }
 
 std::list<Coord> Segment::GetGraphic() const {
-  Segment normalized(a_point_, b_point_);
-  if (a_point_ > b_point_) {
-    std::swap(normalized.a_point_, normalized.b_point_);
-  }
-
-  float k_coefficient = GetKCoefficient(*this);
-  int b_coefficient = normalized.GetBCoefficient();
-
   std::list<Coord> graphic;
-
-  if (k_coefficient == FLT_MAX) {
-    for (int y = normalized.a_point_.y; y <= normalized.b_point_.y; ++y) {
-      graphic.push_back({normalized.b_point_.x, y});
-    }
-  } else if (k_coefficient <= 1 && k_coefficient >= -1) {
-    for (int x = normalized.a_point_.x; x <= normalized.b_point_.x; ++x) {
-      graphic.push_back(
-          {x, static_cast<int>(k_coefficient * x + b_coefficient)});
-    }
-  } else {
-    int inc = k_coefficient >= 0 ? 1 : -1;
-    for (int y = normalized.a_point_.y;
-         inc > 0 ? y <= normalized.b_point_.y : y >= normalized.b_point_.y;
-         y += inc) {
-      graphic.push_back(
-          {static_cast<int>(static_cast<float>(y) / k_coefficient -
-                            static_cast<float>(b_coefficient) / k_coefficient),
-           y});
-    }
-  }
+  ForEachPixel(*this, [&graphic](const Coord& point) {
+    graphic.push_back(point);
+  });
   return graphic;
 }
 
-int Segment::GetBCoefficient() const {
-  if (b_point_.x - a_point_.x == 0) {
-    return 0;
-  }
-  return ((static_cast<int64_t>(b_point_.x) * a_point_.y) -
-          (static_cast<int64_t>(a_point_.x) * b_point_.y)) /
-         (b_point_.x - a_point_.x);
-}
-
 Coord Segment::GetCenter() const {
   return {(a_point_.x + b_point_.x) / 2, (a_point_.y + b_point_.y) / 2};
 }
@@ -156,37 +124,12 @@ void Segment::SetKCoef(double new_k) {
   b_point_ = {center.x + delta_x, center.y + delta_y};
 }
 
-std::list<Coord> Segment::GetArea(int radius) const {
-  std::list<Coord> area;
-
-  area.splice(area.cend(), Circe(a_point_, radius).GetGraphic());
-  area.splice(area.cend(), Circe(b_point_, radius).GetGraphic());
-
-  auto init_k = GetKCoefficient(*this);
-  float norm_k;
-  if (init_k == 0) {
-    norm_k = FLT_MAX;
-  } else if (init_k == FLT_MAX) {
-    norm_k = 0;
-  } else {
-    norm_k = -(1 / init_k);
-  }
-
-  Segment from_a({a_point_, a_point_});
-  from_a.SetLen(radius * 2);
-  from_a.SetKCoef(norm_k);
-
-  Segment from_b({b_point_, b_point_});
-  from_b.SetLen(radius * 2);
-  from_b.SetKCoef(norm_k);
-
-  Segment upper_bound(from_a.b_point_, from_b.b_point_);
-  Segment lower_bound(from_a.a_point_, from_b.a_point_);
-
-  area.splice(area.cend(), upper_bound.GetGraphic());
-  area.splice(area.cend(), lower_bound.GetGraphic());
-
-  return FulfillArea(area);
+SpanArea Segment::GetArea(int radius) const {
+  std::vector<Span> spans;
+  ForEachSpan(*this, radius, [&spans](int y, int x_begin, int x_end) {
+    spans.push_back({y, x_begin, x_end});
+  });
+  return SpanArea(std::move(spans));
 }
 
 /*--------------------------------- triangle ---------------------------------*/
@@ -200,14 +143,20 @@ std::tuple<Coord, Coord, Coord> Triangle::GetPoints() const {
 
 std::list<Coord> Triangle::GetGraphic() const {
   std::list<Coord> graphic;
-
-  graphic.splice(graphic.cend(), Segment(a_point_, b_point_).GetGraphic());
-  graphic.splice(graphic.cend(), Segment(b_point_, c_point_).GetGraphic());
-  graphic.splice(graphic.cend(), Segment(c_point_, a_point_).GetGraphic());
-
+  ForEachPixel(*this, [&graphic](const Coord& point) {
+    graphic.push_back(point);
+  });
   return graphic;
 }
 
+SpanArea Triangle::GetArea() const {
+  std::vector<Span> spans;
+  ForEachSpan(*this, [&spans](int y, int x_begin, int x_end) {
+    spans.push_back({y, x_begin, x_end});
+  });
+  return SpanArea(std::move(spans));
+}
+
 /*---------------------------------- circle ----------------------------------*/
 Circe::Circe(const PTIT::Coord& center, double radius)
     : center_(center), radius_(radius) {}
@@ -218,43 +167,20 @@ int& Circe::GetRadius() { return radius_; }
 int Circe::GetRadius() const { return radius_; }
 
 std::list<Coord> Circe::GetGraphic() const {
-  // second quarter
-  std::list<Coord> quarter_graphic;
-  int64_t sqr_radius = radius_ * radius_;
-  quarter_graphic.push_front({-radius_, 0});
-  for (int x = -radius_ + 1; x <= 0; ++x) {
-    int64_t sqr_x = x * x;
-    int y = sqrt(sqr_radius - sqr_x);
-
-    while (quarter_graphic.front().y < y - 1) {
-      quarter_graphic.push_front({x, quarter_graphic.front().y + 1});
-    }
-    quarter_graphic.push_front({x, y});
-  }
-
-  // first quarter
+  auto stencil = GetStencilCache().Get(radius_);
   std::list<Coord> graphic;
-  for (auto iter = std::next(quarter_graphic.begin());
-       iter != quarter_graphic.end(); ++iter) {
-    graphic.push_front({-iter->x, iter->y});
-  }
-
-  graphic.splice(graphic.cend(), std::move(quarter_graphic));
-
-  // third and fourth quarter
-  for (auto iter = std::next(graphic.rbegin());
-       iter != std::prev(graphic.rend()); ++iter) {
-    graphic.push_back({iter->x, -iter->y});
-  }
-
-  // moving to center
-  std::for_each(graphic.begin(), graphic.end(), [this](Coord& coord) {
-    coord = {coord.x + center_.x, coord.y + center_.y};
+  ForEachPixel(*stencil, center_, [&graphic](const Coord& point) {
+    graphic.push_back(point);
   });
-
   return graphic;
 }
 
+SpanArea Circe::GetArea() const {
+  SpanArea area = GetStencilCache().Get(radius_)->disc;
+  area.Translate(center_);
+  return area;
+}
+
 /*------------------------------ free functions ------------------------------*/
 double GetDistance(const Coord& first, const Coord& second) noexcept {
   double dx = second.x - first.x;
@@ -268,30 +194,34 @@ double RadToDeg(double rad) { return rad * (kDegInCircle / 2) / kPi; }
 double TanToDeg(double tan) { return RadToDeg(atan(tan)); }
 double NormalizeDeg(double deg) { return deg < 0 ? deg + 360 : deg; }
 
-std::list<Coord> FulfillArea(const std::list<Coord>& border) {
-  std::vector<Coord> sorted_border;
-  sorted_border.reserve(border.size());
-  sorted_border.assign(border.begin(), border.end());
-
-  std::sort(sorted_border.begin(), sorted_border.end(),
-            [](const Coord& first, const Coord& second) {
-              return first.y == second.y ? first.x < second.x
-                                         : first.y < second.y;
-            });
-
-  std::list<Coord> area;
-  area.assign(sorted_border.begin(), sorted_border.end());
-
-  for (auto iter = std::next(area.begin()); iter != area.end(); ++iter) {
-    if (std::prev(iter)->y != iter->y) {
-      continue;
-    }
-    while (std::prev(iter)->x < iter->x - 1) {
-      area.insert(iter, {std::prev(iter)->x + 1, iter->y});
-    }
+template <typename Points>
+SpanArea FulfillBorder(const Points& border) {
+  if (border.empty()) {
+    return {};
+  }
+  auto [min_iter, max_iter] =
+      std::minmax_element(border.begin(), border.end(),
+                          [](const Coord& first, const Coord& second) {
+                            return first.y < second.y;
+                          });
+  int min_y = min_iter->y;
+
+  std::vector<Span> rows(max_iter->y - min_y + 1, {0, INT_MAX, INT_MIN});
+  for (const auto& point : border) {
+    auto& row = rows[point.y - min_y];
+    row.y = point.y;
+    row.x_begin = std::min(row.x_begin, point.x);
+    row.x_end = std::max(row.x_end, point.x + 1);
   }
 
-  return area;
+  return SpanArea(std::move(rows));
+}
+
+SpanArea FulfillArea(const std::list<Coord>& border) {
+  return FulfillBorder(border);
+}
+SpanArea FulfillArea(const std::vector<Coord>& border) {
+  return FulfillBorder(border);
 }
 
 }  // namespace PTIT
@@ -0,0 +1,103 @@
+#include "span-area.hpp"
+
+#include <algorithm>
+
+namespace PTIT {
+
+bool operator==(const Span& first, const Span& second) noexcept {
+  return first.y == second.y && first.x_begin == second.x_begin &&
+         first.x_end == second.x_end;
+}
+
+bool SpanLess(const Span& first, const Span& second) noexcept {
+  return first.y == second.y ? first.x_begin < second.x_begin
+                             : first.y < second.y;
+}
+
+SpanArea::SpanArea(std::vector<Span> spans) {
+  std::erase_if(spans,
+                [](const Span& span) { return span.x_begin >= span.x_end; });
+  std::sort(spans.begin(), spans.end(), SpanLess);
+
+  // merging overlapping and touching spans
+  spans_.reserve(spans.size());
+  for (const auto& span : spans) {
+    if (!spans_.empty() && spans_.back().y == span.y &&
+        spans_.back().x_end >= span.x_begin) {
+      spans_.back().x_end = std::max(spans_.back().x_end, span.x_end);
+    } else {
+      spans_.push_back(span);
+    }
+  }
+}
+
+size_t SpanArea::Size() const {
+  size_t size = 0;
+  for (const auto& span : spans_) {
+    size += span.x_end - span.x_begin;
+  }
+  return size;
+}
+
+bool SpanArea::Contains(const Coord& point) const {
+  auto iter = std::upper_bound(
+      spans_.begin(), spans_.end(), Span{point.y, point.x, point.x + 1},
+      SpanLess);
+  if (iter == spans_.begin()) {
+    return false;
+  }
+  --iter;
+  return iter->y == point.y && point.x < iter->x_end;
+}
+
+void SpanArea::Fill() {
+  size_t size = 0;
+  for (const auto& span : spans_) {
+    if (size != 0 && spans_[size - 1].y == span.y) {
+      spans_[size - 1].x_end = span.x_end;
+    } else {
+      spans_[size++] = span;
+    }
+  }
+  spans_.resize(size);
+}
+
+void SpanArea::Translate(const Coord& offset) {
+  for (auto& span : spans_) {
+    span.y += offset.y;
+    span.x_begin += offset.x;
+    span.x_end += offset.x;
+  }
+}
+
+SpanArea SpanArea::Unite(const SpanArea& other) const {
+  std::vector<Span> spans;
+  spans.reserve(spans_.size() + other.spans_.size());
+  std::merge(spans_.begin(), spans_.end(), other.spans_.begin(),
+             other.spans_.end(), std::back_inserter(spans), SpanLess);
+  return SpanArea(std::move(spans));
+}
+
+SpanArea SpanArea::Intersect(const SpanArea& other) const {
+  SpanArea intersection;
+  auto first = spans_.begin();
+  auto second = other.spans_.begin();
+
+  while (first != spans_.end() && second != other.spans_.end()) {
+    if (first->y != second->y) {
+      first->y < second->y ? ++first : ++second;
+      continue;
+    }
+    int x_begin = std::max(first->x_begin, second->x_begin);
+    int x_end = std::min(first->x_end, second->x_end);
+    if (x_begin < x_end) {
+      intersection.spans_.push_back({first->y, x_begin, x_end});
+    }
+    first->x_end < second->x_end ? ++first : ++second;
+  }
+  return intersection;
+}
+
+std::list<Coord> SpanArea::GetPoints() const { return {begin(), end()}; }
+
+}  // namespace PTIT
@@ -0,0 +1,98 @@
+#include "stencil-cache.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#include "primitives.hpp"
+#include "raster.hpp"
+
+namespace PTIT {
+
+Stencil::Stencil(int radius) : radius(std::max(radius, 0)) {
+  Circe circle({0, 0}, this->radius);
+  ForEachPixel(circle,
+               [this](const Coord& point) { outline.push_back(point); });
+
+  std::vector<Span> spans;
+  spans.reserve(2 * this->radius + 1);
+  ForEachSpan(circle, [&spans](int y, int x_begin, int x_end) {
+    spans.push_back({y, x_begin, x_end});
+  });
+  disc = SpanArea(std::move(spans));
+}
+
+size_t Stencil::Bytes() const {
+  return sizeof(Stencil) + outline.capacity() * sizeof(Coord) +
+         disc.GetSpans().capacity() * sizeof(Span);
+}
+
+StencilCache::StencilCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+std::shared_ptr<const Stencil> StencilCache::Get(int radius) {
+  radius = std::max(radius, 0);
+  {
+    std::shared_lock lock(mutex_);
+    auto iter = stencils_.find(radius);
+    if (iter != stencils_.end()) {
+      ++hits_;
+      // the line is written only when the bit changes
+      if (!iter->second.referenced.load(std::memory_order_relaxed)) {
+        iter->second.referenced.store(true, std::memory_order_relaxed);
+      }
+      return iter->second.stencil;
+    }
+  }
+
+  ++misses_;
+  // built unlocked, another thread may be building the same one
+  auto stencil = std::make_shared<const Stencil>(radius);
+  size_t bytes = stencil->Bytes();
+  if (bytes > max_bytes_) {
+    return stencil;
+  }
+
+  std::unique_lock lock(mutex_);
+  auto [iter, inserted] = stencils_.try_emplace(radius, stencil);
+  if (!inserted) {
+    return iter->second.stencil;
+  }
+  clock_.push_back(radius);
+  bytes_ += bytes;
+  // the hand clears the bits it passes, so it drops one within a round; new
+  // stencils have no bit set, so one-off radii go before the ones in use
+  while (bytes_ > max_bytes_) {
+    auto hand = stencils_.find(clock_.front());
+    clock_.pop_front();
+    if (hand->second.referenced.exchange(false, std::memory_order_relaxed)) {
+      clock_.push_back(hand->first);
+      continue;
+    }
+    bytes_ -= hand->second.stencil->Bytes();
+    stencils_.erase(hand);
+  }
+  return stencil;
+}
+
+size_t StencilCache::Size() const {
+  std::shared_lock lock(mutex_);
+  return stencils_.size();
+}
+
+size_t StencilCache::Bytes() const {
+  std::shared_lock lock(mutex_);
+  return bytes_;
+}
+
+void StencilCache::Clear() {
+  std::unique_lock lock(mutex_);
+  stencils_.clear();
+  clock_.clear();
+  bytes_ = 0;
+}
+
+StencilCache& GetStencilCache() {
+  static StencilCache cache;
+  return cache;
+}
+
+}  // namespace PTIT
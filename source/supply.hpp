@@ -7,6 +7,10 @@ namespace PTIT {
 const double kPi = 3.1415926535;
 const int kDegInCircle = 360;
 
+// neighbourhood of a pixel, x-major order
+const Coord kNeighbourOffsets[] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+                                   {0, 1},   {1, -1}, {1, 0},  {1, 1}};
+
 float GetKCoefficient(const Segment& segment);
 
 }  // namespace PTIT
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "thread-pool.hpp"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace PTIT {
+
+ThreadPool::ThreadPool(int threads)
+    : ranges_(std::make_unique<Range[]>(std::max(threads, 1))) {
+  for (int worker = 1; worker < threads; ++worker) {
+    workers_.emplace_back([this, worker] { WorkerLoop(worker); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Run(int count, TaskCaller caller, void* task) {
+  if (workers_.empty() || count <= 1) {
+    for (int index = 0; index < count; ++index) {
+      caller(task, index, 0);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard lock(mutex_);
+    caller_ = caller;
+    task_ = task;
+    for (int worker = 0; worker < Size(); ++worker) {
+      ranges_[worker].begin = static_cast<int>(
+          static_cast<int64_t>(count) * worker / Size());
+      ranges_[worker].end = static_cast<int>(
+          static_cast<int64_t>(count) * (worker + 1) / Size());
+    }
+    active_ = static_cast<int>(workers_.size());
+    exception_ = nullptr;
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  Process(0);
+
+  std::unique_lock lock(mutex_);
+  done_.wait(lock, [this] { return active_ == 0; });
+  if (exception_) {
+    std::rethrow_exception(std::exchange(exception_, nullptr));
+  }
+}
+
+void ThreadPool::WorkerLoop(int worker) {
+  size_t seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock lock(mutex_);
+      wake_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+      if (stop_) {
+        return;
+      }
+      seen_generation = generation_;
+    }
+
+    Process(worker);
+
+    std::lock_guard lock(mutex_);
+    if (--active_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::Process(int worker) {
+  int index = 0;
+  while (Take(worker, index) || Steal(worker, index)) {
+    try {
+      caller_(task_, index, worker);
+    } catch (...) {
+      std::lock_guard lock(mutex_);
+      if (!exception_) {
+        exception_ = std::current_exception();
+      }
+    }
+  }
+}
+
+bool ThreadPool::Take(int worker, int& index) {
+  auto& range = ranges_[worker];
+  std::lock_guard lock(range.mutex);
+  if (range.begin == range.end) {
+    return false;
+  }
+  index = range.begin++;
+  return true;
+}
+
+bool ThreadPool::Steal(int worker, int& index) {
+  for (int shift = 1; shift < Size(); ++shift) {
+    auto& victim = ranges_[(worker + shift) % Size()];
+    int begin = 0;
+    int end = 0;
+    {
+      std::lock_guard lock(victim.mutex);
+      if (victim.begin == victim.end) {
+        continue;
+      }
+      end = victim.end;
+      begin = victim.end - (victim.end - victim.begin + 1) / 2;
+      victim.end = begin;
+    }
+
+    auto& range = ranges_[worker];
+    std::lock_guard lock(range.mutex);
+    index = begin;
+    range.begin = begin + 1;
+    range.end = end;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace PTIT
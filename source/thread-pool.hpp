@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace PTIT {
+
+class ThreadPool {
+ public:
+  // the calling thread takes part in the work, so `threads` - 1 workers are
+  // spawned
+  explicit ThreadPool(int threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int Size() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // calls task(index, worker) for every index in [0, count) and returns when
+  // all of them are finished; worker is in [0, Size()). Every worker starts
+  // with its own block of indices and takes them in order, an idle one steals
+  // the back half of the indices left to another.
+  template <typename Task>
+  void ParallelFor(int count, Task&& task) {
+    Run(count,
+        [](void* task, int index, int worker) {
+          (*static_cast<std::remove_reference_t<Task>*>(task))(index, worker);
+        },
+        &task);
+  }
+
+ private:
+  using TaskCaller = void (*)(void*, int, int);
+
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  bool stop_ = false;
+  size_t generation_ = 0;
+  int active_ = 0;
+
+  // indices [begin, end) left to a worker
+  struct alignas(64) Range {
+    std::mutex mutex;
+    int begin = 0;
+    int end = 0;
+  };
+
+  TaskCaller caller_ = nullptr;
+  void* task_ = nullptr;
+  std::unique_ptr<Range[]> ranges_;
+  std::exception_ptr exception_;
+
+  void Run(int count, TaskCaller caller, void* task);
+  void WorkerLoop(int worker);
+  void Process(int worker);
+  bool Take(int worker, int& index);
+  bool Steal(int worker, int& index);
+};
+
+}  // namespace PTIT